@@ -0,0 +1,198 @@
+#include "base_patch.h"
+
+#include "json_reader.h"
+
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+namespace serialization_catalogue {
+
+namespace {
+
+using namespace std::literals;
+
+using TransportCatalogue = transport::catalogue::TransportCatalogue;
+
+// Stop and Bus requests of delta by name, the last request of the same name is used.
+// Names of added ones are kept in order of delta
+struct DeltaRequests {
+	std::map<std::string_view, const json::Dict*> stops;
+	std::map<std::string_view, const json::Dict*> buses;
+	std::vector<std::string_view> stop_order;
+	std::vector<std::string_view> bus_order;
+	std::set<std::string_view> removed_stops;
+	std::set<std::string_view> removed_buses;
+};
+
+DeltaRequests ReadDeltaRequests(const TransportCatalogue& base, const json::Dict& delta) {
+	DeltaRequests requests;
+
+	if (const auto it = delta.find("removed_requests"s); it != delta.end()) {
+		for (const auto& node : it->second.AsArray()) {
+			const auto& request = node.AsMap();
+			const auto type = request.at("type"s).AsStringView();
+			const auto name = request.at("name"s).AsStringView();
+			if (type == "Stop"sv && base.FindStopId(name)) {
+				requests.removed_stops.insert(name);
+			} else if (type == "Bus"sv && base.FindBusId(name)) {
+				requests.removed_buses.insert(name);
+			} else {
+				throw std::invalid_argument("Can't remove unknown "s + std::string(type) + " "s + std::string(name));
+			}
+		}
+	}
+
+	if (const auto it = delta.find("base_requests"s); it != delta.end()) {
+		for (const auto& node : it->second.AsArray()) {
+			const auto& request = node.AsMap();
+			const auto type = request.at("type"s).AsStringView();
+			const auto name = request.at("name"s).AsStringView();
+			if (type == "Stop"sv) {
+				if (requests.stops.count(name) == 0) {
+					requests.stop_order.push_back(name);
+				}
+				requests.stops[name] = &request;
+			} else if (type == "Bus"sv) {
+				if (requests.buses.count(name) == 0) {
+					requests.bus_order.push_back(name);
+				}
+				requests.buses[name] = &request;
+			}
+		}
+	}
+	return requests;
+}
+
+// Stops of bus request in order of route, back way is added for not round route
+std::vector<StopId> GetRequestRoute(const TransportCatalogue& catalogue, const json::Dict& request) {
+	const auto& stop_names = request.at("stops"s).AsArray();
+	std::vector<StopId> stops;
+	stops.reserve(stop_names.size() * 2);
+	for (const auto& stop_name : stop_names) {
+		const auto stop = catalogue.FindStopId(stop_name.AsStringView());
+		if (!stop) {
+			throw std::invalid_argument("Unknown stop "s + std::string(stop_name.AsStringView()) + " of bus "s + request.at("name"s).AsString());
+		}
+		stops.push_back(*stop);
+	}
+	if (!request.at("is_roundtrip"s).AsBool()) {
+		for (int i = static_cast<int>(stop_names.size()) - 2; i >= 0; --i) {
+			stops.push_back(stops[i]);
+		}
+	}
+	return stops;
+}
+
+} // namespace
+
+
+UnchangedBuses PatchCatalogue(const TransportCatalogue& base, const json::Dict& delta, TransportCatalogue& catalogue) {
+	const auto requests = ReadDeltaRequests(base, delta);
+	const auto& base_stops = base.GetAllStops();
+	const auto& base_buses = base.GetAllBuses();
+	catalogue.Reserve(base_stops.size() + requests.stop_order.size(), base_buses.size() + requests.bus_order.size());
+
+	UnchangedBuses unchanged;
+	unchanged.new_stops.resize(base_stops.size());
+	// Stops which are added or replaced by delta, every bus through them is changed
+	std::vector<bool> is_touched;
+
+	const auto add_stop = [&catalogue, &is_touched](std::string_view name, const transport::detail::Coordinates& coordinates, bool touched) {
+		is_touched.push_back(touched);
+		return catalogue.AddNewStop(name, coordinates);
+	};
+	const auto get_coordinates = [](const json::Dict& request) -> transport::detail::Coordinates {
+		return { request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble() };
+	};
+
+	// Stops of base in their order, then added ones
+	for (StopId stop = 0; stop < base_stops.size(); ++stop) {
+		const auto& name = base_stops[stop].stop_name;
+		if (requests.removed_stops.count(name) > 0) {
+			continue;
+		}
+		const auto it = requests.stops.find(name);
+		unchanged.new_stops[stop] = it == requests.stops.end()
+			? add_stop(name, base_stops[stop].coordinates, false)
+			: add_stop(name, get_coordinates(*it->second), true);
+	}
+	for (const auto name : requests.stop_order) {
+		if (!catalogue.FindStopId(name)) {
+			add_stop(name, get_coordinates(*requests.stops.at(name)), true);
+		}
+	}
+
+	// Distances of base between kept stops, then distances of delta replace them
+	base.RealStopDistanceData().ForEach([&](const transport::detail::RoadDistance& road) {
+		if (unchanged.new_stops[road.from] && unchanged.new_stops[road.to]) {
+			catalogue.AddDstBetweenStops(*unchanged.new_stops[road.from], road.distance, *unchanged.new_stops[road.to]);
+		}
+	});
+	for (const auto name : requests.stop_order) {
+		const auto& request = *requests.stops.at(name);
+		if (const auto it = request.find("road_distances"s); it != request.end()) {
+			const StopId from = *catalogue.FindStopId(name);
+			for (const auto& [stop_to, distance] : it->second.AsMap()) {
+				const auto to = catalogue.FindStopId(stop_to);
+				if (!to) {
+					throw std::invalid_argument("Unknown stop "s + stop_to + " in road distances of "s + std::string(name));
+				}
+				catalogue.AddDstBetweenStops(from, distance.AsInt(), *to);
+			}
+		}
+	}
+
+	// Buses of base in their order, then added ones
+	for (BusId bus = 0; bus < base_buses.size(); ++bus) {
+		const auto& base_bus = base_buses[bus];
+		if (requests.removed_buses.count(base_bus.bus_number) > 0) {
+			continue;
+		}
+		if (const auto it = requests.buses.find(base_bus.bus_number); it != requests.buses.end()) {
+			catalogue.AddNewBus(base_bus.bus_number, GetRequestRoute(catalogue, *it->second), it->second->at("is_roundtrip"s).AsBool());
+			unchanged.old_buses.emplace_back();
+			continue;
+		}
+
+		std::vector<StopId> stops;
+		stops.reserve(base_bus.bus_route.size());
+		bool touched = false;
+		for (const StopId stop : base_bus.bus_route) {
+			// Removed stop may be added again by delta
+			const auto new_stop = unchanged.new_stops[stop] ? unchanged.new_stops[stop] : catalogue.FindStopId(base_stops[stop].stop_name);
+			if (!new_stop) {
+				throw std::invalid_argument("Removed stop "s + base_stops[stop].stop_name + " is used by bus "s + base_bus.bus_number);
+			}
+			stops.push_back(*new_stop);
+			touched = touched || is_touched[*new_stop];
+		}
+		catalogue.AddNewBus(base_bus.bus_number, std::move(stops), base_bus.is_roundtrip);
+		unchanged.old_buses.push_back(touched ? std::nullopt : std::optional<BusId>(bus));
+	}
+	for (const auto name : requests.bus_order) {
+		if (!catalogue.FindBusId(name)) {
+			const auto& request = *requests.buses.at(name);
+			catalogue.AddNewBus(name, GetRequestRoute(catalogue, request), request.at("is_roundtrip"s).AsBool());
+			unchanged.old_buses.emplace_back();
+		}
+	}
+
+	// Routing settings of base are kept unless delta has new ones
+	if (const auto it = delta.find("routing_settings"s); it != delta.end()) {
+		FillRoutingSettings(catalogue, it->second.AsMap());
+	} else {
+		catalogue.SetBusWaitTime(base.BusWaitTime());
+		catalogue.SetBusVelocity(base.BusVelocity());
+		catalogue.SetRouterType(base.GetRouterType());
+		catalogue.SetRouteGraphModel(base.GetRouteGraphModel());
+	}
+	return unchanged;
+}
+
+} // namespace serialization_catalogue
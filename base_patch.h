@@ -0,0 +1,25 @@
+#pragma once
+
+#include "json.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+
+namespace serialization_catalogue {
+
+/* ********************************* BASE PATCH ********************************* */
+
+// Delta of patch_base document changes stops and buses of base:
+//   "base_requests" are Stop and Bus requests like in make_base, stop or bus with known name is replaced,
+//   road_distances of stop replace its distances to given stops, other distances of the stop are kept;
+//   "removed_requests" are {"type": "Stop" or "Bus", "name": ...}, they are applied before base_requests;
+//   "routing_settings" replace settings of base.
+// Stops and buses keep their order, added ones go after them
+
+// Fill empty catalogue with stops, buses, distances and routing_settings of base with delta applied.
+// Bus is unchanged if its route and stops of the route aren't touched by delta, its derived data may be copied from base.
+// Throws std::invalid_argument if delta refers to unknown stop or bus, or removed stop is used by bus
+UnchangedBuses PatchCatalogue(const transport::catalogue::TransportCatalogue& base, const json::Dict& delta,
+                              transport::catalogue::TransportCatalogue& catalogue);
+
+} // namespace serialization_catalogue
@@ -0,0 +1,558 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Contraction hierarchies engine.
+// Constructor contracts vertices one by one (ordered by edge difference) and adds shortcuts
+// that keep shortest distances between remaining vertices. A query is a bidirectional Dijkstra
+// which goes only "up" in contraction order, so it touches a small part of the graph.
+// Shortcuts are unpacked back into original edge ids of the graph.
+template <typename Weight>
+class ContractionHierarchy final : public RoutingEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using ArcId = size_t;
+
+public:
+    using typename RoutingEngine<Weight>::RouteInfo;
+
+    // Original edge or shortcut. Arcs [0, edge count) are the graph edges with the same ids,
+    // a shortcut replaces path first_child -> second_child
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        ArcId first_child = NO_ARC;
+        ArcId second_child = NO_ARC;
+    };
+
+    // Result of preprocessing, enough to restore the engine for the same graph
+    struct Hierarchy {
+        std::vector<size_t> ranks;
+        std::vector<Arc> shortcuts;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+
+    // Use hierarchy precomputed earlier for the same graph (e.g. loaded from file)
+    ContractionHierarchy(const Graph& graph, Hierarchy hierarchy);
+
+    // Contract vertices in given order instead of computing priorities, e.g. in order of ranks of hierarchy
+    // built for a slightly different graph. Every vertex must be in order once
+    ContractionHierarchy(const Graph& graph, const std::vector<VertexId>& contraction_order);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetShortcutCount() const {
+        return arcs_.size() - graph_.GetEdgeCount();
+    }
+
+    Hierarchy GetHierarchy() const {
+        return {ranks_, {arcs_.begin() + graph_.GetEdgeCount(), arcs_.end()}};
+    }
+
+    // Position of every vertex in contraction order
+    const std::vector<size_t>& GetRanks() const {
+        return ranks_;
+    }
+
+private:
+
+    // Arc to neighbour with the smallest weight
+    struct Neighbour {
+        VertexId vertex;
+        ArcId arc;
+        Weight weight;
+    };
+
+    // Mutable data used only while contracting
+    struct ContractionState {
+        std::vector<std::vector<ArcId>> out_arcs;
+        std::vector<std::vector<ArcId>> in_arcs;
+        std::vector<bool> contracted;
+        std::vector<int> deleted_neighbours;
+
+        // Witness search buffers
+        std::vector<Weight> weights;
+        std::vector<VertexId> touched;
+        std::vector<bool> targets;
+    };
+
+    // Buffers of one direction of a query, reused between queries of one thread
+    struct SearchSpace {
+        std::vector<Weight> weights;
+        std::vector<ArcId> prev_arcs;
+        std::vector<VertexId> touched;
+    };
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    void AddGraphArcs();
+    ContractionState StartContraction() const;
+    void ContractGraph();
+    void ContractGraph(const std::vector<VertexId>& contraction_order);
+    std::vector<Neighbour> GetNeighbours(const ContractionState& state, VertexId vertex, bool outgoing) const;
+    void RunWitnessSearch(ContractionState& state, VertexId source, VertexId ignored, Weight max_weight,
+                          size_t target_count, size_t settled_limit) const;
+    int ContractVertex(ContractionState& state, VertexId vertex, bool simulate);
+    void BuildSearchGraph();
+    void RelaxUpward(SearchSpace& space, Queue& queue, VertexId vertex, Weight weight, bool forward) const;
+    void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight MAX_WEIGHT = std::numeric_limits<Weight>::max();
+    static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+    // Witness search gives up after this number of settled vertices and a shortcut is added.
+    // Priority estimation may be rougher than real contraction
+    static constexpr size_t SIMULATION_SETTLED_LIMIT = 50;
+    static constexpr size_t CONTRACTION_SETTLED_LIMIT = 500;
+
+    const Graph& graph_;
+    std::vector<Arc> arcs_;
+    std::vector<size_t> ranks_;
+
+    // Search graph in CSR layout. up_arcs_ of vertex u are arcs u -> w with rank(w) > rank(u),
+    // down_arcs_ of vertex w are arcs u -> w with rank(u) > rank(w) (used by backward search)
+    std::vector<size_t> up_offsets_;
+    std::vector<ArcId> up_arcs_;
+    std::vector<size_t> down_offsets_;
+    std::vector<ArcId> down_arcs_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+    , ranks_(graph.GetVertexCount())
+{
+    AddGraphArcs();
+    ContractGraph();
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, Hierarchy hierarchy)
+    : graph_(graph)
+    , ranks_(std::move(hierarchy.ranks))
+{
+    if (ranks_.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Hierarchy doesn't match the graph");
+    }
+    arcs_.reserve(graph.GetEdgeCount() + hierarchy.shortcuts.size());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        arcs_.push_back({edge.from, edge.to, edge.weight});
+    }
+    for (const Arc& shortcut : hierarchy.shortcuts) {
+        if (shortcut.first_child >= arcs_.size() || shortcut.second_child >= arcs_.size()) {
+            throw std::invalid_argument("Hierarchy doesn't match the graph");
+        }
+        arcs_.push_back(shortcut);
+    }
+
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, const std::vector<VertexId>& contraction_order)
+    : graph_(graph)
+    , ranks_(graph.GetVertexCount())
+{
+    AddGraphArcs();
+    ContractGraph(contraction_order);
+    BuildSearchGraph();
+}
+
+// Graph edges are the first arcs
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddGraphArcs() {
+    arcs_.reserve(graph_.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        arcs_.push_back({edge.from, edge.to, edge.weight});
+    }
+}
+
+template <typename Weight>
+typename ContractionHierarchy<Weight>::ContractionState ContractionHierarchy<Weight>::StartContraction() const {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    ContractionState state;
+    state.out_arcs.resize(vertex_count);
+    state.in_arcs.resize(vertex_count);
+    state.contracted.assign(vertex_count, false);
+    state.deleted_neighbours.assign(vertex_count, 0);
+    state.weights.assign(vertex_count, MAX_WEIGHT);
+    state.targets.assign(vertex_count, false);
+
+    for (ArcId arc_id = 0; arc_id < arcs_.size(); ++arc_id) {
+        // Loops never make a route shorter
+        if (arcs_[arc_id].from != arcs_[arc_id].to) {
+            state.out_arcs[arcs_[arc_id].from].push_back(arc_id);
+            state.in_arcs[arcs_[arc_id].to].push_back(arc_id);
+        }
+    }
+    return state;
+}
+
+// Contract vertices in order of their priority, priorities are updated lazily
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    ContractionState state = StartContraction();
+
+    using PriorityItem = std::pair<int, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({ContractVertex(state, vertex, true), vertex});
+    }
+
+    size_t rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+
+        // Priority may be outdated since neighbours were contracted
+        const int priority = ContractVertex(state, vertex, true);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+
+        ContractVertex(state, vertex, false);
+        ranks_[vertex] = rank++;
+    }
+}
+
+// Contract vertices in given order, priorities aren't computed
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractGraph(const std::vector<VertexId>& contraction_order) {
+    if (contraction_order.size() != graph_.GetVertexCount()) {
+        throw std::invalid_argument("Contraction order doesn't match the graph");
+    }
+    ContractionState state = StartContraction();
+
+    size_t rank = 0;
+    for (const VertexId vertex : contraction_order) {
+        if (vertex >= graph_.GetVertexCount() || state.contracted[vertex]) {
+            throw std::invalid_argument("Contraction order doesn't match the graph");
+        }
+        ContractVertex(state, vertex, false);
+        ranks_[vertex] = rank++;
+    }
+}
+
+// Get not contracted neighbours of vertex, parallel arcs are reduced to the lightest one
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::Neighbour>
+ContractionHierarchy<Weight>::GetNeighbours(const ContractionState& state, VertexId vertex, bool outgoing) const {
+    std::vector<Neighbour> neighbours;
+    for (const ArcId arc_id : outgoing ? state.out_arcs[vertex] : state.in_arcs[vertex]) {
+        const Arc& arc = arcs_[arc_id];
+        const VertexId other = outgoing ? arc.to : arc.from;
+        if (!state.contracted[other]) {
+            neighbours.push_back({other, arc_id, arc.weight});
+        }
+    }
+    std::sort(neighbours.begin(), neighbours.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+        return lhs.vertex < rhs.vertex || (lhs.vertex == rhs.vertex && lhs.weight < rhs.weight);
+    });
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+        return lhs.vertex == rhs.vertex;
+    }), neighbours.end());
+    return neighbours;
+}
+
+// Bounded Dijkstra from source over not contracted vertices except ignored one.
+// Stops when all marked targets are settled
+template <typename Weight>
+void ContractionHierarchy<Weight>::RunWitnessSearch(ContractionState& state, VertexId source, VertexId ignored,
+                                                    Weight max_weight, size_t target_count, size_t settled_limit) const {
+    for (const VertexId vertex : state.touched) {
+        state.weights[vertex] = MAX_WEIGHT;
+    }
+    state.touched.clear();
+
+    Queue queue;
+    state.weights[source] = ZERO_WEIGHT;
+    state.touched.push_back(source);
+    queue.push({ZERO_WEIGHT, source});
+
+    size_t settled_count = 0;
+    while (!queue.empty() && settled_count < settled_limit && target_count > 0) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > state.weights[vertex]) {
+            continue;
+        }
+        if (weight > max_weight) {
+            break;
+        }
+        ++settled_count;
+        if (state.targets[vertex]) {
+            --target_count;
+        }
+        for (const ArcId arc_id : state.out_arcs[vertex]) {
+            const Arc& arc = arcs_[arc_id];
+            if (arc.to == ignored || state.contracted[arc.to]) {
+                continue;
+            }
+            const Weight candidate_weight = weight + arc.weight;
+            if (candidate_weight < state.weights[arc.to]) {
+                if (state.weights[arc.to] == MAX_WEIGHT) {
+                    state.touched.push_back(arc.to);
+                }
+                state.weights[arc.to] = candidate_weight;
+                queue.push({candidate_weight, arc.to});
+            }
+        }
+    }
+}
+
+// Contract vertex (or only count its priority if simulate is set), returns priority of vertex:
+// number of shortcuts minus number of removed arcs plus number of already contracted neighbours
+template <typename Weight>
+int ContractionHierarchy<Weight>::ContractVertex(ContractionState& state, VertexId vertex, bool simulate) {
+    const auto in_neighbours = GetNeighbours(state, vertex, false);
+    const auto out_neighbours = GetNeighbours(state, vertex, true);
+
+    for (const Neighbour& out : out_neighbours) {
+        state.targets[out.vertex] = true;
+    }
+
+    int shortcut_count = 0;
+    for (const Neighbour& in : in_neighbours) {
+        Weight max_weight = ZERO_WEIGHT;
+        for (const Neighbour& out : out_neighbours) {
+            if (out.vertex != in.vertex) {
+                max_weight = std::max(max_weight, in.weight + out.weight);
+            }
+        }
+        // Source itself is marked when it is an out neighbour too, it is settled first
+        const size_t target_count = out_neighbours.size();
+        RunWitnessSearch(state, in.vertex, vertex, max_weight, target_count,
+                         simulate ? SIMULATION_SETTLED_LIMIT : CONTRACTION_SETTLED_LIMIT);
+
+        for (const Neighbour& out : out_neighbours) {
+            if (out.vertex == in.vertex) {
+                continue;
+            }
+            const Weight shortcut_weight = in.weight + out.weight;
+            if (state.weights[out.vertex] <= shortcut_weight) {
+                continue;
+            }
+            ++shortcut_count;
+            if (!simulate) {
+                const ArcId arc_id = arcs_.size();
+                arcs_.push_back({in.vertex, out.vertex, shortcut_weight, in.arc, out.arc});
+                state.out_arcs[in.vertex].push_back(arc_id);
+                state.in_arcs[out.vertex].push_back(arc_id);
+            }
+        }
+    }
+
+    for (const Neighbour& out : out_neighbours) {
+        state.targets[out.vertex] = false;
+    }
+
+    if (!simulate) {
+        state.contracted[vertex] = true;
+        // Arcs to the contracted vertex are not needed by next witness searches
+        for (const Neighbour& in : in_neighbours) {
+            auto& arcs = state.out_arcs[in.vertex];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [this, vertex](ArcId arc_id) {
+                return arcs_[arc_id].to == vertex;
+            }), arcs.end());
+            ++state.deleted_neighbours[in.vertex];
+        }
+        for (const Neighbour& out : out_neighbours) {
+            auto& arcs = state.in_arcs[out.vertex];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [this, vertex](ArcId arc_id) {
+                return arcs_[arc_id].from == vertex;
+            }), arcs.end());
+            ++state.deleted_neighbours[out.vertex];
+        }
+    }
+
+    return shortcut_count - static_cast<int>(in_neighbours.size() + out_neighbours.size())
+        + state.deleted_neighbours[vertex];
+}
+
+// Split all arcs into upward and downward ones and store them in CSR layout
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    up_offsets_.assign(vertex_count + 1, 0);
+    down_offsets_.assign(vertex_count + 1, 0);
+
+    for (const Arc& arc : arcs_) {
+        if (ranks_[arc.from] < ranks_[arc.to]) {
+            ++up_offsets_[arc.from + 1];
+        } else if (ranks_[arc.from] > ranks_[arc.to]) {
+            ++down_offsets_[arc.to + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        up_offsets_[vertex + 1] += up_offsets_[vertex];
+        down_offsets_[vertex + 1] += down_offsets_[vertex];
+    }
+
+    up_arcs_.resize(up_offsets_.back());
+    down_arcs_.resize(down_offsets_.back());
+    std::vector<size_t> up_positions(up_offsets_.begin(), up_offsets_.end() - 1);
+    std::vector<size_t> down_positions(down_offsets_.begin(), down_offsets_.end() - 1);
+    for (ArcId arc_id = 0; arc_id < arcs_.size(); ++arc_id) {
+        const Arc& arc = arcs_[arc_id];
+        if (ranks_[arc.from] < ranks_[arc.to]) {
+            up_arcs_[up_positions[arc.from]++] = arc_id;
+        } else if (ranks_[arc.from] > ranks_[arc.to]) {
+            down_arcs_[down_positions[arc.to]++] = arc_id;
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::RelaxUpward(SearchSpace& space, Queue& queue, VertexId vertex, Weight weight,
+                                               bool forward) const {
+    const auto& offsets = forward ? up_offsets_ : down_offsets_;
+    const auto& arcs = forward ? up_arcs_ : down_arcs_;
+    for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+        const Arc& arc = arcs_[arcs[i]];
+        const VertexId next = forward ? arc.to : arc.from;
+        const Weight candidate_weight = weight + arc.weight;
+        if (candidate_weight < space.weights[next]) {
+            if (space.weights[next] == MAX_WEIGHT) {
+                space.touched.push_back(next);
+            }
+            space.weights[next] = candidate_weight;
+            space.prev_arcs[next] = arcs[i];
+            queue.push({candidate_weight, next});
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+    std::vector<ArcId> stack{arc_id};
+    while (!stack.empty()) {
+        const Arc& arc = arcs_[stack.back()];
+        if (arc.first_child == NO_ARC) {
+            edges.push_back(stack.back());
+            stack.pop_back();
+        } else {
+            stack.back() = arc.second_child;
+            stack.push_back(arc.first_child);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+                                                                                                         VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    // Buffers are allocated once per thread and cleaned up after every query,
+    // so BuildRoute may be called concurrently
+    thread_local SearchSpace forward_space;
+    thread_local SearchSpace backward_space;
+    for (SearchSpace* space : {&forward_space, &backward_space}) {
+        if (space->weights.size() < vertex_count || space->prev_arcs.size() < vertex_count) {
+            space->weights.resize(vertex_count, MAX_WEIGHT);
+            space->prev_arcs.resize(vertex_count, NO_ARC);
+        }
+    }
+
+    // Touched vertices are reset on any exit, a query which throws doesn't spoil next queries of the thread.
+    // Vertex is put into touched before its weight is set
+    struct SpaceCleaner {
+        ~SpaceCleaner() {
+            for (SearchSpace* space : {&forward_space, &backward_space}) {
+                for (const VertexId vertex : space->touched) {
+                    space->weights[vertex] = MAX_WEIGHT;
+                    space->prev_arcs[vertex] = NO_ARC;
+                }
+                space->touched.clear();
+            }
+        }
+    } space_cleaner;
+
+    Queue forward_queue;
+    Queue backward_queue;
+    forward_space.touched.push_back(from);
+    forward_space.weights[from] = ZERO_WEIGHT;
+    forward_queue.push({ZERO_WEIGHT, from});
+    backward_space.touched.push_back(to);
+    backward_space.weights[to] = ZERO_WEIGHT;
+    backward_queue.push({ZERO_WEIGHT, to});
+
+    Weight best_weight = MAX_WEIGHT;
+    VertexId meeting_vertex = vertex_count;
+
+    // Every direction stops when its closest vertex is farther than the best route found
+    while (true) {
+        const bool forward_active = !forward_queue.empty() && forward_queue.top().first < best_weight;
+        const bool backward_active = !backward_queue.empty() && backward_queue.top().first < best_weight;
+        if (!forward_active && !backward_active) {
+            break;
+        }
+        const bool forward = forward_active
+            && (!backward_active || forward_queue.top().first <= backward_queue.top().first);
+
+        SearchSpace& space = forward ? forward_space : backward_space;
+        const SearchSpace& other_space = forward ? backward_space : forward_space;
+        Queue& queue = forward ? forward_queue : backward_queue;
+
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (weight > space.weights[vertex]) {
+            continue;
+        }
+        if (other_space.weights[vertex] != MAX_WEIGHT && weight + other_space.weights[vertex] < best_weight) {
+            best_weight = weight + other_space.weights[vertex];
+            meeting_vertex = vertex;
+        }
+        RelaxUpward(space, queue, vertex, weight, forward);
+    }
+
+    std::optional<RouteInfo> result;
+    if (meeting_vertex != vertex_count) {
+        std::vector<ArcId> route_arcs;
+        for (VertexId vertex = meeting_vertex; vertex != from; vertex = arcs_[forward_space.prev_arcs[vertex]].from) {
+            route_arcs.push_back(forward_space.prev_arcs[vertex]);
+        }
+        std::reverse(route_arcs.begin(), route_arcs.end());
+        for (VertexId vertex = meeting_vertex; vertex != to; vertex = arcs_[backward_space.prev_arcs[vertex]].to) {
+            route_arcs.push_back(backward_space.prev_arcs[vertex]);
+        }
+
+        std::vector<EdgeId> edges;
+        for (const ArcId arc_id : route_arcs) {
+            UnpackArc(arc_id, edges);
+        }
+        result = RouteInfo{best_weight, std::move(edges)};
+    }
+    return result;
+}
+
+}  // namespace graph
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "graph.h"
+#include "ranges.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace graph {
+
+// Frozen copy of DirectedWeightedGraph in compressed sparse row layout.
+// Outgoing arcs of vertex v are positions [ArcsBegin(v), ArcsEnd(v)) of contiguous arrays
+// of targets, weights and edge ids, so a search walks memory sequentially.
+// GetEdge and GetIncidentEdges work the same way as in DirectedWeightedGraph, edge ids are kept.
+template <typename Weight>
+class CsrGraph {
+private:
+    using IncidentEdgesRange = ranges::Range<typename std::vector<EdgeId>::const_iterator>;
+
+public:
+    CsrGraph() = default;
+    explicit CsrGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const;
+    size_t GetEdgeCount() const;
+    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+
+    size_t ArcsBegin(VertexId vertex) const {
+        return offsets_[vertex];
+    }
+
+    size_t ArcsEnd(VertexId vertex) const {
+        return offsets_[vertex + 1];
+    }
+
+    VertexId GetArcTarget(size_t arc) const {
+        return targets_[arc];
+    }
+
+    Weight GetArcWeight(size_t arc) const {
+        return weights_[arc];
+    }
+
+    EdgeId GetArcEdgeId(size_t arc) const {
+        return edge_ids_[arc];
+    }
+
+private:
+    std::vector<size_t> offsets_;
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edge_ids_;
+    std::vector<Edge<Weight>> edges_;
+};
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight>& graph)
+    : offsets_(graph.GetVertexCount() + 1, 0)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    targets_.reserve(edge_count);
+    weights_.reserve(edge_count);
+    edge_ids_.reserve(edge_count);
+    edges_.reserve(edge_count);
+
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        edges_.push_back(graph.GetEdge(edge_id));
+    }
+    // Incidence lists keep order of edges, so searches over both layouts visit edges in the same order
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            targets_.push_back(edges_[edge_id].to);
+            weights_.push_back(edges_[edge_id].weight);
+            edge_ids_.push_back(edge_id);
+        }
+        offsets_[vertex + 1] = edge_ids_.size();
+    }
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetVertexCount() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetEdgeCount() const {
+    return edges_.size();
+}
+
+template <typename Weight>
+const Edge<Weight>& CsrGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return edges_.at(edge_id);
+}
+
+template <typename Weight>
+typename CsrGraph<Weight>::IncidentEdgesRange CsrGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+    return {edge_ids_.begin() + offsets_.at(vertex), edge_ids_.begin() + offsets_.at(vertex + 1)};
+}
+
+}  // namespace graph
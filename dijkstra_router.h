@@ -0,0 +1,138 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Shortest routes from one vertex: weights[v] is MAX_WEIGHT if v is not reached,
+// prev_edges[v] is the last edge of route to v or NO_EDGE for the origin and not reached vertices
+template <typename Weight>
+struct ShortestPathTree {
+    static constexpr Weight MAX_WEIGHT = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    VertexId from = 0;
+    std::vector<Weight> weights;
+    std::vector<EdgeId> prev_edges;
+
+    // Route from the origin to vertex or nothing if vertex is not reached
+    std::optional<typename RoutingEngine<Weight>::RouteInfo> BuildRoute(const CsrGraph<Weight>& graph,
+                                                                        VertexId to) const;
+};
+
+// Binary heap Dijkstra from vertex over whole graph, or until target is settled if it is given.
+// Buffers are local to the call, so it may be called concurrently
+template <typename Weight>
+ShortestPathTree<Weight> BuildShortestPathTree(const CsrGraph<Weight>& graph, VertexId from,
+                                               std::optional<VertexId> target = std::nullopt);
+
+// Per-query engine: binary heap Dijkstra with early exit on target.
+// Nothing is precomputed except a CSR copy of the graph, memory used by a query is linear in graph size.
+template <typename Weight>
+class DijkstraRouter final : public RoutingEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RoutingEngine<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+
+    CsrGraph<Weight> graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    if (to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+    return BuildShortestPathTree(graph_, from, to).BuildRoute(graph_, to);
+}
+
+template <typename Weight>
+ShortestPathTree<Weight> BuildShortestPathTree(const CsrGraph<Weight>& graph, VertexId from,
+                                               std::optional<VertexId> target) {
+    using Tree = ShortestPathTree<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    constexpr Weight ZERO_WEIGHT{};
+
+    const size_t vertex_count = graph.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+
+    Tree tree{from, std::vector<Weight>(vertex_count, Tree::MAX_WEIGHT), std::vector<EdgeId>(vertex_count, Tree::NO_EDGE)};
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+    tree.weights[from] = ZERO_WEIGHT;
+    queue.push({ZERO_WEIGHT, from});
+
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        // Outdated item, vertex is already settled with smaller weight
+        if (weight > tree.weights[vertex]) {
+            continue;
+        }
+        if (target && vertex == *target) {
+            break;
+        }
+        for (size_t arc = graph.ArcsBegin(vertex); arc < graph.ArcsEnd(vertex); ++arc) {
+            const VertexId arc_target = graph.GetArcTarget(arc);
+            const Weight candidate_weight = weight + graph.GetArcWeight(arc);
+            if (candidate_weight < tree.weights[arc_target]) {
+                tree.weights[arc_target] = candidate_weight;
+                tree.prev_edges[arc_target] = graph.GetArcEdgeId(arc);
+                queue.push({candidate_weight, arc_target});
+            }
+        }
+    }
+
+    return tree;
+}
+
+template <typename Weight>
+std::optional<typename RoutingEngine<Weight>::RouteInfo> ShortestPathTree<Weight>::BuildRoute(const CsrGraph<Weight>& graph,
+                                                                                              VertexId to) const {
+    if (weights.at(to) == MAX_WEIGHT) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = prev_edges[to]; edge_id != NO_EDGE; edge_id = prev_edges[graph.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return typename RoutingEngine<Weight>::RouteInfo{weights[to], std::move(edges)};
+}
+
+}  // namespace graph
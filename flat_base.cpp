@@ -0,0 +1,560 @@
+#include "flat_base.h"
+
+#include "ranges.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FLAT_BASE_MMAP
+#endif
+
+
+namespace serialization_catalogue {
+
+namespace {
+
+using namespace std::literals;
+
+constexpr std::array<char, 8> FLAT_MAGIC{ 'T', 'C', 'F', 'L', 'A', 'T', '\0', '\0' };
+constexpr std::uint32_t FLAT_VERSION = 1;
+// Is read as other number on machine with other byte order
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr std::uint64_t SECTION_ALIGNMENT = 8;
+
+enum class SectionId : std::uint32_t {
+	STRINGS = 1,                // names of stops and buses, FlatString refers to them
+	STOPS,                      // FlatStop, index is StopId
+	BUSES,                      // FlatBus, index is BusId
+	ROUTES,                     // StopId of all bus routes one after another
+	DISTANCE_OFFSETS,           // frozen RoadDistances table
+	DISTANCE_TARGETS,
+	DISTANCE_VALUES,
+	DISTANCE_MEASURED,          // one byte per arc
+	SETTINGS,                   // one FlatSettings
+	RENDER_SETTINGS,            // serialized protobuf message RenderSettings
+	GRAPH_EDGES,                // graph::Edge<double>, index is EdgeId
+	EDGES_INFO,                 // FlatEdgeInfo, index is EdgeId
+	FLOYD_WARSHALL_WEIGHTS,     // RoutesInternalData of graph::Router as is
+	FLOYD_WARSHALL_PREV_EDGES,
+	HIERARCHY_RANKS,            // Hierarchy of graph::ContractionHierarchy as is
+	HIERARCHY_SHORTCUTS
+};
+
+struct FileHeader {
+	std::array<char, 8> magic;
+	std::uint32_t version;
+	std::uint32_t byte_order;
+	std::uint32_t size_t_size;
+	std::uint32_t section_count;
+};
+
+// offset is from the file begin, size is in bytes
+struct SectionHeader {
+	std::uint32_t id;
+	std::uint32_t reserved;
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+
+// Part of string table
+struct FlatString {
+	std::uint64_t offset;
+	std::uint64_t size;
+};
+
+struct FlatStop {
+	FlatString name;
+	double latitude;
+	double longitude;
+};
+
+// Route is [route_offset, route_offset + route_size) of ROUTES, statistics are stored with bus
+struct FlatBus {
+	FlatString name;
+	std::uint64_t route_offset;
+	std::uint32_t route_size;
+	std::uint32_t is_roundtrip;
+	std::uint32_t stop_count;
+	std::uint32_t unique_stop_count;
+	std::int32_t route_length;
+	std::uint32_t reserved;
+	double geo_length;
+};
+
+// routing_settings and size of route graph
+struct FlatSettings {
+	std::int32_t bus_wait_time;
+	std::uint32_t router_type;
+	double bus_velocity;
+	std::uint32_t route_graph_model;
+	std::uint32_t reserved;
+	std::uint64_t vertex_count;
+};
+
+struct FlatEdgeInfo {
+	std::int32_t span_count;
+	std::uint32_t bus;
+	std::uint32_t type;
+	std::uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24 && sizeof(SectionHeader) == 24);
+static_assert(sizeof(FlatStop) == 32 && sizeof(FlatBus) == 56 && sizeof(FlatSettings) == 32 && sizeof(FlatEdgeInfo) == 16);
+
+using FloydWarshall = graph::Router<double>;
+using ContractionHierarchy = graph::ContractionHierarchy<double>;
+
+std::uint64_t AlignSection(std::uint64_t offset) {
+	return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+
+// Sections point to data of caller until the file is written, nothing is copied
+class FlatWriter {
+public:
+	template <typename T>
+	void AddSection(SectionId id, const T* data, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		sections_.push_back({ id, reinterpret_cast<const char*>(data), count * sizeof(T) });
+	}
+
+	template <typename Container>
+	void AddSection(SectionId id, const Container& container) {
+		AddSection(id, container.data(), container.size());
+	}
+
+	void Write(const std::string& file) const;
+
+private:
+	struct Section {
+		SectionId id;
+		const char* data;
+		size_t size;
+	};
+
+	std::vector<Section> sections_;
+};
+
+
+void FlatWriter::Write(const std::string& file) const {
+	// Mapped base keeps old file while temporary one replaces it
+	const std::string temp_file = file + ".tmp"s;
+	std::ofstream out_file(temp_file, std::ios::binary);
+
+	if (!out_file.is_open()) {
+		throw std::logic_error("Can't open file");
+	}
+
+	const FileHeader header{ FLAT_MAGIC, FLAT_VERSION, BYTE_ORDER_MARK, sizeof(size_t), static_cast<std::uint32_t>(sections_.size()) };
+	std::vector<SectionHeader> table;
+	table.reserve(sections_.size());
+	const std::uint64_t table_end = sizeof(FileHeader) + sections_.size() * sizeof(SectionHeader);
+	std::uint64_t offset = AlignSection(table_end);
+	for (const auto& section : sections_) {
+		table.push_back({ static_cast<std::uint32_t>(section.id), 0, offset, section.size });
+		offset = AlignSection(offset + section.size);
+	}
+
+	out_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out_file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionHeader));
+	std::uint64_t position = table_end;
+	const std::array<char, SECTION_ALIGNMENT> padding{};
+	for (size_t i = 0; i < sections_.size(); ++i) {
+		out_file.write(padding.data(), table[i].offset - position);
+		out_file.write(sections_[i].data, sections_[i].size);
+		position = table[i].offset + table[i].size;
+	}
+
+	out_file.close();
+	if (!out_file) {
+		throw std::logic_error("Can't write file");
+	}
+	std::filesystem::rename(temp_file, file);
+}
+
+
+// Whole file in memory: mapped if it's possible, read otherwise
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& file);
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile();
+
+	std::string_view GetData() const {
+		return data_;
+	}
+
+private:
+	bool Map(const std::string& file);
+
+	void* mapped_ = nullptr;
+	size_t mapped_size_ = 0;
+	std::string text_;
+	std::string_view data_;
+};
+
+
+MappedFile::MappedFile(const std::string& file) {
+	if (Map(file)) {
+		return;
+	}
+	std::ifstream in_file(file, std::ios::binary);
+	if (!in_file.is_open()) {
+		throw std::logic_error("Can't open file");
+	}
+	text_.assign(std::istreambuf_iterator<char>(in_file), std::istreambuf_iterator<char>());
+	data_ = text_;
+}
+
+
+MappedFile::~MappedFile() {
+#ifdef FLAT_BASE_MMAP
+	if (mapped_ != nullptr) {
+		munmap(mapped_, mapped_size_);
+	}
+#endif
+}
+
+
+bool MappedFile::Map(const std::string& file) {
+#ifdef FLAT_BASE_MMAP
+	const int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	// All arrays are read at once, so pages are loaded in advance where it's possible
+#ifdef MAP_POPULATE
+	const int flags = MAP_PRIVATE | MAP_POPULATE;
+#else
+	const int flags = MAP_PRIVATE;
+#endif
+	void* const mapped = mmap(nullptr, file_stat.st_size, PROT_READ, flags, fd, 0);
+	// Mapping stays valid after the file is closed
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+	mapped_ = mapped;
+	mapped_size_ = file_stat.st_size;
+	data_ = std::string_view(static_cast<const char*>(mapped), mapped_size_);
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// Sections of flat base, header and table are checked once when it's created
+class FlatReader {
+public:
+	explicit FlatReader(std::string_view data);
+
+	// Records of section, empty if there is no such section
+	template <typename T>
+	ranges::Range<const T*> GetSection(SectionId id) const;
+
+	// Section of exactly one record
+	template <typename T>
+	const T& GetRecord(SectionId id) const;
+
+	std::string_view GetString(const FlatString& string) const;
+
+private:
+	std::string_view data_;
+	std::vector<SectionHeader> table_;
+	std::string_view strings_;
+};
+
+
+FlatReader::FlatReader(std::string_view data) : data_(data) {
+	FileHeader header;
+	if (data_.size() < sizeof(header)) {
+		throw std::logic_error("Can't parse file");
+	}
+	std::memcpy(&header, data_.data(), sizeof(header));
+	if (header.magic != FLAT_MAGIC) {
+		throw std::logic_error("Can't parse file");
+	}
+	if (header.version != FLAT_VERSION || header.byte_order != BYTE_ORDER_MARK || header.size_t_size != sizeof(size_t)) {
+		throw std::logic_error("Flat base is made for other version or machine");
+	}
+	if ((data_.size() - sizeof(header)) / sizeof(SectionHeader) < header.section_count) {
+		throw std::logic_error("Can't parse file");
+	}
+
+	table_.resize(header.section_count);
+	std::memcpy(table_.data(), data_.data() + sizeof(header), table_.size() * sizeof(SectionHeader));
+	for (const auto& section : table_) {
+		if (section.offset > data_.size() || section.size > data_.size() - section.offset) {
+			throw std::logic_error("Can't parse file");
+		}
+	}
+
+	const auto strings = GetSection<char>(SectionId::STRINGS);
+	strings_ = std::string_view(strings.begin(), strings.end() - strings.begin());
+}
+
+
+template <typename T>
+ranges::Range<const T*> FlatReader::GetSection(SectionId id) const {
+	static_assert(std::is_trivially_copyable_v<T>);
+	for (const auto& section : table_) {
+		if (section.id != static_cast<std::uint32_t>(id)) {
+			continue;
+		}
+		const char* const begin = data_.data() + section.offset;
+		if (section.size % sizeof(T) != 0 || reinterpret_cast<std::uintptr_t>(begin) % alignof(T) != 0) {
+			throw std::logic_error("Broken section of flat base");
+		}
+		const T* const records = reinterpret_cast<const T*>(begin);
+		return { records, records + section.size / sizeof(T) };
+	}
+	return { nullptr, nullptr };
+}
+
+
+template <typename T>
+const T& FlatReader::GetRecord(SectionId id) const {
+	const auto records = GetSection<T>(id);
+	if (records.end() - records.begin() != 1) {
+		throw std::logic_error("Broken section of flat base");
+	}
+	return *records.begin();
+}
+
+
+std::string_view FlatReader::GetString(const FlatString& string) const {
+	if (string.offset > strings_.size() || string.size > strings_.size() - string.offset) {
+		throw std::logic_error("Broken section of flat base");
+	}
+	return strings_.substr(string.offset, string.size);
+}
+
+
+template <typename T>
+std::vector<T> ToVector(ranges::Range<const T*> records) {
+	return { records.begin(), records.end() };
+}
+
+
+// Records of route graph and routing engine are stored in layout of memory
+void AddRouterSections(FlatWriter& writer, const TransportCatalogue& catalogue, const SingleBusRoute& router,
+	std::vector<graph::Edge<double>>& edges, std::vector<FlatEdgeInfo>& edges_info, ContractionHierarchy::Hierarchy& hierarchy) {
+	const auto& graph = router.GetGraph();
+	edges.reserve(graph.GetEdgeCount());
+	for (size_t i = 0; i < graph.GetEdgeCount(); ++i) {
+		edges.push_back(graph.GetEdge(i));
+	}
+	writer.AddSection(SectionId::GRAPH_EDGES, edges);
+
+	edges_info.reserve(router.GetEdgesInfo().size());
+	for (const EdgeInfo& edge_info : router.GetEdgesInfo()) {
+		edges_info.push_back({ edge_info.stop_numb, *catalogue.FindBusId(edge_info.bus_name), static_cast<std::uint32_t>(edge_info.type), 0 });
+	}
+	writer.AddSection(SectionId::EDGES_INFO, edges_info);
+
+	// Dijkstra has nothing precomputed
+	if (const auto* floyd_warshall = dynamic_cast<const FloydWarshall*>(&router.GetRouter())) {
+		const auto& routes = floyd_warshall->GetRoutesInternalData();
+		writer.AddSection(SectionId::FLOYD_WARSHALL_WEIGHTS, routes.weights);
+		writer.AddSection(SectionId::FLOYD_WARSHALL_PREV_EDGES, routes.prev_edges);
+	} else if (const auto* contraction_hierarchy = dynamic_cast<const ContractionHierarchy*>(&router.GetRouter())) {
+		hierarchy = contraction_hierarchy->GetHierarchy();
+		writer.AddSection(SectionId::HIERARCHY_RANKS, hierarchy.ranks);
+		writer.AddSection(SectionId::HIERARCHY_SHORTCUTS, hierarchy.shortcuts);
+	}
+}
+
+
+// Restore router from stored graph, engine is built if its data isn't stored
+std::unique_ptr<SingleBusRoute> ReadRouter(const FlatReader& reader, const FlatSettings& settings, const TransportCatalogue& catalogue) {
+	SingleBusRoute::Graph graph(settings.vertex_count, ToVector(reader.GetSection<graph::Edge<double>>(SectionId::GRAPH_EDGES)));
+
+	std::vector<EdgeInfo> edges_info;
+	const auto flat_edges_info = reader.GetSection<FlatEdgeInfo>(SectionId::EDGES_INFO);
+	edges_info.reserve(flat_edges_info.end() - flat_edges_info.begin());
+	const auto& buses = catalogue.GetAllBuses();
+	for (const FlatEdgeInfo& edge_info : flat_edges_info) {
+		edges_info.push_back(EdgeInfo{ edge_info.span_count, buses.at(edge_info.bus).bus_number, static_cast<EdgeType>(edge_info.type) });
+	}
+
+	const auto create_router = [&reader, &catalogue](const SingleBusRoute::Graph& graph) -> std::unique_ptr<graph::RoutingEngine<double>> {
+		using RouterType = transport::detail::RouterType;
+		const auto router_type = catalogue.GetRouterType();
+
+		if (router_type == RouterType::FLOYD_WARSHALL) {
+			FloydWarshall::RoutesInternalData routes;
+			routes.vertex_count = graph.GetVertexCount();
+			routes.weights = ToVector(reader.GetSection<double>(SectionId::FLOYD_WARSHALL_WEIGHTS));
+			routes.prev_edges = ToVector(reader.GetSection<graph::EdgeId>(SectionId::FLOYD_WARSHALL_PREV_EDGES));
+			if (routes.weights.empty() && routes.prev_edges.empty()) {
+				return std::make_unique<FloydWarshall>(graph);
+			}
+			if (routes.weights.size() != routes.vertex_count * routes.vertex_count || routes.prev_edges.size() != routes.weights.size()) {
+				throw std::logic_error("Broken Floyd-Warshall data");
+			}
+			return std::make_unique<FloydWarshall>(graph, std::move(routes));
+		}
+
+		if (router_type == RouterType::CONTRACTION_HIERARCHY) {
+			ContractionHierarchy::Hierarchy hierarchy;
+			hierarchy.ranks = ToVector(reader.GetSection<size_t>(SectionId::HIERARCHY_RANKS));
+			hierarchy.shortcuts = ToVector(reader.GetSection<ContractionHierarchy::Arc>(SectionId::HIERARCHY_SHORTCUTS));
+			if (hierarchy.ranks.empty()) {
+				return std::make_unique<ContractionHierarchy>(graph);
+			}
+			return std::make_unique<ContractionHierarchy>(graph, std::move(hierarchy));
+		}
+
+		return std::make_unique<graph::DijkstraRouter<double>>(graph);
+	};
+
+	return std::make_unique<SingleBusRoute>(catalogue, std::move(graph), std::move(edges_info), create_router);
+}
+
+} // namespace
+
+
+/* ********************************* FLAT BASE ********************************* */
+
+// Write catalogue, render settings and router into file as flat base
+void WriteFlatBase(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const SingleBusRoute& router, const std::string& file) {
+	FlatWriter writer;
+
+	std::string strings;
+	const auto add_string = [&strings](std::string_view string) {
+		const FlatString flat_string{ strings.size(), string.size() };
+		strings += string;
+		return flat_string;
+	};
+
+	std::vector<FlatStop> stops;
+	stops.reserve(catalogue.GetAllStops().size());
+	for (const SingleStop& stop : catalogue.GetAllStops()) {
+		stops.push_back({ add_string(stop.stop_name), stop.coordinates.lat, stop.coordinates.lng });
+	}
+
+	std::vector<FlatBus> buses;
+	std::vector<StopId> routes;
+	const auto bus_count = static_cast<BusId>(catalogue.GetAllBuses().size());
+	buses.reserve(bus_count);
+	for (BusId bus = 0; bus < bus_count; ++bus) {
+		const SingleBus& single_bus = catalogue.GetBus(bus);
+		const auto& stats = catalogue.GetBusStats(bus);
+		buses.push_back({ add_string(single_bus.bus_number), routes.size(), static_cast<std::uint32_t>(single_bus.bus_route.size()),
+			single_bus.is_roundtrip, static_cast<std::uint32_t>(stats.stop_count), static_cast<std::uint32_t>(stats.unique_stop_count),
+			stats.route_length, 0, stats.geo_length });
+		routes.insert(routes.end(), single_bus.bus_route.begin(), single_bus.bus_route.end());
+	}
+
+	writer.AddSection(SectionId::STRINGS, strings);
+	writer.AddSection(SectionId::STOPS, stops);
+	writer.AddSection(SectionId::BUSES, buses);
+	writer.AddSection(SectionId::ROUTES, routes);
+
+	const auto& distances = catalogue.RealStopDistanceData();
+	const std::vector<std::uint8_t> measured(distances.GetMeasured().begin(), distances.GetMeasured().end());
+	writer.AddSection(SectionId::DISTANCE_OFFSETS, distances.GetOffsets());
+	writer.AddSection(SectionId::DISTANCE_TARGETS, distances.GetTargets());
+	writer.AddSection(SectionId::DISTANCE_VALUES, distances.GetDistances());
+	writer.AddSection(SectionId::DISTANCE_MEASURED, measured);
+
+	const FlatSettings settings{ catalogue.BusWaitTime(), static_cast<std::uint32_t>(catalogue.GetRouterType()),
+		static_cast<double>(catalogue.BusVelocity()), static_cast<std::uint32_t>(catalogue.GetRouteGraphModel()), 0,
+		router.GetGraph().GetVertexCount() };
+	writer.AddSection(SectionId::SETTINGS, &settings, 1);
+
+	// Render settings are small and have strings, they are stored as protobuf message
+	const std::string serialized_render_settings = GetSerializedRenderSettings(render_settings).SerializeAsString();
+	writer.AddSection(SectionId::RENDER_SETTINGS, serialized_render_settings);
+
+	std::vector<graph::Edge<double>> edges;
+	std::vector<FlatEdgeInfo> edges_info;
+	ContractionHierarchy::Hierarchy hierarchy;
+	AddRouterSections(writer, catalogue, router, edges, edges_info, hierarchy);
+
+	writer.Write(file);
+}
+
+
+// Check that file starts with header of flat base
+bool IsFlatBase(const std::string& file) {
+	std::ifstream in_file(file, std::ios::binary);
+	std::array<char, FLAT_MAGIC.size()> magic{};
+	return in_file.read(magic.data(), magic.size()) && magic == FLAT_MAGIC;
+}
+
+
+// Read flat base made by WriteFlatBase, throws std::logic_error if the file is broken or has other version
+void ReadFlatBase(const std::string& file, TransportCatalogue& catalogue, RenderSettings& render_settings, std::unique_ptr<SingleBusRoute>& router) {
+	const MappedFile mapped_file(file);
+	const FlatReader reader(mapped_file.GetData());
+
+	const auto stops = reader.GetSection<FlatStop>(SectionId::STOPS);
+	const auto buses = reader.GetSection<FlatBus>(SectionId::BUSES);
+	catalogue.Reserve(stops.end() - stops.begin(), buses.end() - buses.begin());
+	for (const FlatStop& stop : stops) {
+		catalogue.AddNewStop(reader.GetString(stop.name), { stop.latitude, stop.longitude });
+	}
+
+	const auto routes = reader.GetSection<StopId>(SectionId::ROUTES);
+	const auto route_count = static_cast<std::uint64_t>(routes.end() - routes.begin());
+	for (const FlatBus& flat_bus : buses) {
+		if (flat_bus.route_offset > route_count || flat_bus.route_size > route_count - flat_bus.route_offset) {
+			throw std::logic_error("Broken section of flat base");
+		}
+		const auto route_begin = routes.begin() + flat_bus.route_offset;
+		const BusId bus = catalogue.AddNewBus(reader.GetString(flat_bus.name), std::vector<StopId>(route_begin, route_begin + flat_bus.route_size), flat_bus.is_roundtrip != 0);
+
+		BusStats stats;
+		stats.stop_count = static_cast<int>(flat_bus.stop_count);
+		stats.unique_stop_count = static_cast<int>(flat_bus.unique_stop_count);
+		stats.route_length = flat_bus.route_length;
+		stats.geo_length = flat_bus.geo_length;
+		stats.curvature = static_cast<double>(stats.route_length / stats.geo_length);
+		catalogue.SetBusStats(bus, stats);
+	}
+
+	const auto measured = reader.GetSection<std::uint8_t>(SectionId::DISTANCE_MEASURED);
+	catalogue.RealStopDistanceData().Assign(ToVector(reader.GetSection<std::uint32_t>(SectionId::DISTANCE_OFFSETS)),
+		ToVector(reader.GetSection<StopId>(SectionId::DISTANCE_TARGETS)), ToVector(reader.GetSection<int>(SectionId::DISTANCE_VALUES)),
+		std::vector<bool>(measured.begin(), measured.end()));
+
+	const auto& settings = reader.GetRecord<FlatSettings>(SectionId::SETTINGS);
+	catalogue.SetBusWaitTime(settings.bus_wait_time);
+	catalogue.SetBusVelocity(settings.bus_velocity);
+	catalogue.SetRouterType(static_cast<transport::detail::RouterType>(settings.router_type));
+	catalogue.SetRouteGraphModel(static_cast<transport::detail::RouteGraphModel>(settings.route_graph_model));
+
+	const auto serialized_render_settings = reader.GetSection<char>(SectionId::RENDER_SETTINGS);
+	SerializedRenderSettings render_settings_message;
+	if (!render_settings_message.ParseFromArray(serialized_render_settings.begin(), static_cast<int>(serialized_render_settings.end() - serialized_render_settings.begin()))) {
+		throw std::logic_error("Broken section of flat base");
+	}
+	render_settings = DeserializeRenderSettings(render_settings_message);
+
+	router = ReadRouter(reader, settings, catalogue);
+}
+
+} // namespace serialization_catalogue
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "serialization.h"
+
+#include <memory>
+#include <string>
+
+
+namespace serialization_catalogue {
+
+/* ********************************* FLAT BASE ********************************* */
+
+// Flat base is an alternative to protobuf base which needs no parsing.
+// File is a header, a table of sections and the sections, every section is an array of fixed size records
+// aligned to 8 bytes: string table with all names, stops, buses, routes as arrays of StopId,
+// road distances as the frozen CSR table, route graph and precomputed data of routing engine.
+// Records keep the layout used in memory, so the file is mapped and arrays are copied into catalogue
+// and router at once. Byte order and size of size_t are checked, the base is read on the same kind of machine
+
+// Write catalogue, render settings and router into file as flat base, it's written as file.tmp and renamed to file
+void WriteFlatBase(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const SingleBusRoute& router, const std::string& file);
+
+// Check that file starts with header of flat base
+bool IsFlatBase(const std::string& file);
+
+// Read flat base made by WriteFlatBase, throws std::logic_error if the file is broken or has other version
+void ReadFlatBase(const std::string& file, TransportCatalogue& catalogue, RenderSettings& render_settings, std::unique_ptr<SingleBusRoute>& router);
+
+} // namespace serialization_catalogue
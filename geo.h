@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <vector>
 
 # define M_PI           3.14159265358979323846
 
@@ -31,18 +34,75 @@ struct Coordinates {
 };
 
     
-inline double ComputeDistance(Coordinates from, Coordinates to) {
-    using namespace std;
-    if (from == to) {
+// Points on the Earth kept as unit vectors in structure of arrays, trigonometry of every point is computed once.
+// Distance is taken by chord between vectors: arithmetic and one asin per segment. Chord is well-conditioned
+// for close points, unlike the former acos form, so lengths of buses with stops a few metres apart may differ
+// from older versions in the low digits
+class GeoPoints {
+public:
+    // Index of point is the order of adding
+    void Add(Coordinates point) {
+        static const double dr = M_PI / 180.;
+        const double lat = point.lat * dr;
+        const double lng = point.lng * dr;
+        x_.push_back(std::cos(lat) * std::cos(lng));
+        y_.push_back(std::cos(lat) * std::sin(lng));
+        z_.push_back(std::sin(lat));
+    }
+
+    size_t size() const {
+        return x_.size();
+    }
+
+    void reserve(size_t count) {
+        x_.reserve(count);
+        y_.reserve(count);
+        z_.reserve(count);
+    }
+
+    // Sum of distances between consecutive points of route.
+    // Chords are computed first by plain arithmetic over arrays, then asin is taken in one loop
+    template <typename Index>
+    double RouteLength(const std::vector<Index>& route) const;
+
+private:
+    double GetChord(size_t from, size_t to) const {
+        const double dx = x_[from] - x_[to];
+        const double dy = y_[from] - y_[to];
+        const double dz = z_[from] - z_[to];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    static double ChordToDistance(double chord) {
+        return 2 * std::asin(std::min(chord / 2, 1.0)) * 6371000;
+    }
+
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> z_;
+};
+
+
+template <typename Index>
+double GeoPoints::RouteLength(const std::vector<Index>& route) const {
+    if (route.size() < 2) {
         return 0;
     }
-    static const double dr = M_PI / 180.;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+    const size_t segment_count = route.size() - 1;
+
+    std::vector<double> chords(segment_count);
+    for (size_t i = 0; i < segment_count; ++i) {
+        chords[i] = GetChord(route[i], route[i + 1]);
+    }
+
+    // Sum goes in order of route, as if distances were added one by one
+    double length = 0;
+    for (const double chord : chords) {
+        length += ChordToDistance(chord);
+    }
+    return length;
 }
 
-        
 } // End namespace detail 
     
 } // End namespace transport
\ No newline at end of file
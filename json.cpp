@@ -1,83 +1,188 @@
 #include "json.h"
 
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <system_error>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define JSON_SSE2_SCAN
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSON_MMAP_INPUT
+#endif
+
 using namespace std;
 
 namespace json {
 
 namespace {
 
-Node LoadNode(istream& input);
+bool IsSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+bool IsStringSpecial(char ch) {
+    return ch == '"' || ch == '\\' || ch == '\n' || ch == '\r';
+}
+
+bool IsDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
 
-Node LoadArray(istream& input) {
+bool IsAlpha(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+// First not space character in [pos, end) or end
+const char* SkipSpaces(const char* pos, const char* end) {
+#ifdef JSON_SSE2_SCAN
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i spaces = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+        const int not_spaces = ~_mm_movemask_epi8(spaces) & 0xFFFF;
+        if (not_spaces != 0) {
+            return pos + __builtin_ctz(not_spaces);
+        }
+    }
+#endif
+    while (pos < end && IsSpace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+// First quote, backslash or line break in [pos, end) or end
+const char* FindStringSpecial(const char* pos, const char* end) {
+#ifdef JSON_SSE2_SCAN
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i specials = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+        const int mask = _mm_movemask_epi8(specials);
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (pos < end && !IsStringSpecial(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+
+// Parser over contiguous text, reads it with a pointer
+class Parser {
+public:
+    Parser(string_view text, StringStorage strings)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , strings_(strings) {
+    }
+
+    Node LoadNode();
+    void ParseNode(Handler& handler);
+
+private:
+    // Next not space character, it is consumed
+    bool ReadChar(char& ch) {
+        pos_ = SkipSpaces(pos_, end_);
+        if (pos_ == end_) {
+            return false;
+        }
+        ch = *pos_++;
+        return true;
+    }
+
+    // Next not space character, it isn't consumed
+    char PeekChar() {
+        pos_ = SkipSpaces(pos_, end_);
+        return pos_ == end_ ? '\0' : *pos_;
+    }
+
+    Node LoadArray();
+    Node LoadDict();
+    Node LoadNumber();
+    string LoadString();
+    Node LoadStringNode();
+    string ParseWord();
+    Node LoadBool();
+    Node LoadNull();
+    Node LoadScalar();
+
+    void ParseArray(Handler& handler);
+    void ParseDict(Handler& handler);
+
+    const char* pos_;
+    const char* const end_;
+    const StringStorage strings_;
+};
+
+
+Node Parser::LoadArray() {
     Array result;
-    char c;
-    for (; input >> c && c != ']';) {
+    char c = 0;
+    while (ReadChar(c) && c != ']') {
         if (c != ',') {
-            input.putback(c);
+            --pos_;
         }
-        result.push_back(LoadNode(input));
+        result.push_back(LoadNode());
     }
-    
+
     if (c != ']') {
         throw ParsingError("LoadArray Error"s);
     }
     return Node(move(result));
-}  
-  
-    
-std::string LoadStringS(std::istream& input); 
-    
-Node LoadDict(istream& input) {
+}
+
+
+Node Parser::LoadDict() {
     Dict result;
-    char c;
-    for (; input >> c && c != '}';) {
+    char c = 0;
+    while (ReadChar(c) && c != '}') {
         if (c == ',') {
-            input >> c;
+            ReadChar(c);
         }
-        string key = LoadStringS(input);
-        input >> c;
-        result.insert({move(key), LoadNode(input)});
+        string key = LoadString();
+        ReadChar(c);
+        result.insert({move(key), LoadNode()});
     }
-    
+
     if (c != '}') {
         throw ParsingError("LoadDict Error"s);
     }
-    
     return Node(move(result));
 }
-    
-   
-using Number = std::variant<int, double>;
 
-Number LoadNumber(std::istream& input) {
-    using namespace std::literals;
 
-    std::string parsed_num;
-
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+Node Parser::LoadNumber() {
+    const char* const begin = pos_;
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    // Пропускает одну или более цифр
+    auto read_digits = [this] {
+        if (pos_ == end_ || !IsDigit(*pos_)) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (pos_ < end_ && IsDigit(*pos_)) {
+            ++pos_;
         }
     };
 
-    if (input.peek() == '-') {
-        read_char();
+    if (pos_ < end_ && *pos_ == '-') {
+        ++pos_;
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
+    if (pos_ < end_ && *pos_ == '0') {
+        ++pos_;
         // После 0 в JSON не могут идти другие цифры
     } else {
         read_digits();
@@ -85,162 +190,223 @@ Number LoadNumber(std::istream& input) {
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
+    if (pos_ < end_ && *pos_ == '.') {
+        ++pos_;
         read_digits();
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+        ++pos_;
+        if (pos_ < end_ && (*pos_ == '+' || *pos_ == '-')) {
+            ++pos_;
         }
         read_digits();
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении,
-                // код ниже попробует преобразовать строку в double
-            }
+    // from_chars не зависит от локали и не создаёт временную строку
+    if (is_int) {
+        int value = 0;
+        const auto [ptr, error] = from_chars(begin, pos_, value);
+        if (error == errc() && ptr == pos_) {
+            return Node(value);
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        // При переполнении int число читается как double
+    }
+    double value = 0;
+    const auto [ptr, error] = from_chars(begin, pos_, value);
+    if (error != errc() || ptr != pos_) {
+        throw ParsingError("Failed to convert "s + string(begin, pos_) + " to number"s);
     }
+    return Node(value);
 }
-    
-    
+
+
 // Считывает содержимое строкового литерала JSON-документа
 // Функцию следует использовать после считывания открывающего символа ":
-std::string LoadStringS(std::istream& input) {
-    using namespace std::literals;
-    
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
+string Parser::LoadString() {
+    string s;
     while (true) {
-        if (it == end) {
+        // Plain characters are copied by whole runs
+        const char* const special = FindStringSpecial(pos_, end_);
+        s.append(pos_, special);
+        pos_ = special;
+        if (pos_ == end_) {
             // Поток закончился до того, как встретили закрывающую кавычку?
             throw ParsingError("String parsing error");
         }
-        const char ch = *it;
+        const char ch = *pos_++;
         if (ch == '"') {
             // Встретили закрывающую кавычку
-            ++it;
             break;
-        } else if (ch == '\\') {
-            // Встретили начало escape-последовательности
-            ++it;
-            if (it == end) {
-                // Поток завершился сразу после символа обратной косой черты
-                throw ParsingError("String parsing error");
-            }
-            const char escaped_char = *(it);
-            // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    // Встретили неизвестную escape-последовательность
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-            }
-        } else if (ch == '\n' || ch == '\r') {
+        }
+        if (ch == '\n' || ch == '\r') {
             // Строковый литерал внутри- JSON не может прерываться символами \r или \n
             throw ParsingError("Unexpected end of line"s);
-        } else {
-            // Просто считываем очередной символ и помещаем его в результирующую строку
-            s.push_back(ch);
         }
-        ++it;
+        // Встретили начало escape-последовательности
+        if (pos_ == end_) {
+            // Поток завершился сразу после символа обратной косой черты
+            throw ParsingError("String parsing error");
+        }
+        const char escaped_char = *pos_++;
+        // Обрабатываем одну из последовательностей: \\, \n, \t, \r, \"
+        switch (escaped_char) {
+            case 'n':
+                s.push_back('\n');
+                break;
+            case 't':
+                s.push_back('\t');
+                break;
+            case 'r':
+                s.push_back('\r');
+                break;
+            case '"':
+                s.push_back('"');
+                break;
+            case '\\':
+                s.push_back('\\');
+                break;
+            default:
+                // Встретили неизвестную escape-последовательность
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+        }
     }
-   // cout << "\n\n LOADED STRING: " << s << " size: " << s.size() <<"\n\n";   
     return s;
 }
-    
-    
-// Get an alphabetic character words from input
-std::string ParseWord(istream& input) {
-    char ch;
-    string str;
-    while (input >> ch && std::isalpha(ch)) {
-        str += ch;
+
+
+// String value, it is a view into text if views are allowed and the string has no escapes
+Node Parser::LoadStringNode() {
+    if (strings_ == StringStorage::VIEW) {
+        const char* const special = FindStringSpecial(pos_, end_);
+        if (special != end_ && *special == '"') {
+            const string_view value(pos_, special - pos_);
+            pos_ = special + 1;
+            return Node(value);
+        }
     }
-    input.putback(ch);
-    return  str;
-}  
-    
+    return Node(LoadString());
+}
+
+
+// Get an alphabetic character word from input
+string Parser::ParseWord() {
+    pos_ = SkipSpaces(pos_, end_);
+    const char* const begin = pos_;
+    while (pos_ < end_ && IsAlpha(*pos_)) {
+        ++pos_;
+    }
+    return string(begin, pos_);
+}
+
 
 // Loads bool-string ("true" || "false") from input
-Node LoadBool(istream& input) {
-    const auto word = ParseWord(input);
-    
+Node Parser::LoadBool() {
+    const auto word = ParseWord();
+
     if (word == "true"s) {
         return Node(true);
     }
-    
+
     if (word == "false"s) {
         return Node(false);
     }
     throw ParsingError("LoadBool Error"s);
 }
-  
-    
+
+
 // Loads "null"-string from input
-Node LoadNull(istream& input) {
-    
-    if (ParseWord(input) == "null"s) {
+Node Parser::LoadNull() {
+    if (ParseWord() == "null"s) {
         return Node(nullptr);
     }
-    
+
     throw ParsingError("LoadNull Error"s);
 }
-    
-    
-Node LoadNode(istream& input) {
+
+
+// Loads string, bool, null or number, the first character isn't consumed yet
+Node Parser::LoadScalar() {
+    const char c = PeekChar();
+    if (c == '"') {
+        ++pos_;
+        return LoadStringNode();
+    } else if (c == 'n') {
+        return LoadNull();
+    } else if (c == 'f' || c == 't') {
+        return LoadBool();
+    }
+    return LoadNumber();
+}
+
+
+Node Parser::LoadNode() {
     char c;
-    input >> c;
+    if (!ReadChar(c)) {
+        throw ParsingError("Unexpected end of input"s);
+    }
     if (c == '[') {
-        return LoadArray(input);
+        return LoadArray();
     } else if (c == '{') {
-        return LoadDict(input);
-    } else if (c == '"') {
-        return Node(LoadStringS(input));
-    } else if (c == 'n') {
-        input.putback(c);
-        return LoadNull(input);
-    } else if (c == 'f' || c == 't') {
-        input.putback(c);
-        return LoadBool(input);
-    } else {
-        input.putback(c);
-        auto tmp = LoadNumber(input);
-        
-        if (holds_alternative<int>(tmp)) {
-            return Node(get<int>(tmp));
+        return LoadDict();
+    }
+    --pos_;
+    return LoadScalar();
+}
+
+
+void Parser::ParseArray(Handler& handler) {
+    handler.StartArray();
+    char c = 0;
+    while (ReadChar(c) && c != ']') {
+        if (c != ',') {
+            --pos_;
         }
-        
-        return Node(get<double>(tmp));
+        ParseNode(handler);
+    }
+
+    if (c != ']') {
+        throw ParsingError("LoadArray Error"s);
+    }
+    handler.EndArray();
+}
+
+
+void Parser::ParseDict(Handler& handler) {
+    handler.StartDict();
+    char c = 0;
+    while (ReadChar(c) && c != '}') {
+        if (c == ',') {
+            ReadChar(c);
+        }
+        handler.Key(LoadString());
+        ReadChar(c);
+        ParseNode(handler);
+    }
+
+    if (c != '}') {
+        throw ParsingError("LoadDict Error"s);
+    }
+    handler.EndDict();
+}
+
+
+// Containers are parsed event by event, scalars are loaded as usual
+void Parser::ParseNode(Handler& handler) {
+    char c;
+    if (!ReadChar(c)) {
+        throw ParsingError("Unexpected end of input"s);
+    }
+    if (c == '[') {
+        ParseArray(handler);
+    } else if (c == '{') {
+        ParseDict(handler);
+    } else {
+        --pos_;
+        handler.Value(LoadScalar());
     }
 }
 
@@ -274,7 +440,7 @@ bool Node::IsBool() const {
     
     
 bool Node::IsString() const {
-    return holds_alternative<string>(value_);
+    return holds_alternative<string>(value_) || holds_alternative<string_view>(value_);
 }
     
     
@@ -338,11 +504,19 @@ double Node::AsDouble() const {
    
     
 const std::string& Node::AsString() const {
-    if (!IsString()) {
-        throw std::logic_error("It's not String"s);
+    if (!holds_alternative<string>(value_)) {
+        throw std::logic_error(IsString() ? "String is a view, use AsStringView"s : "It's not String"s);
     } 
     return std::get<std::string>(value_);
 }
+
+
+std::string_view Node::AsStringView() const {
+    if (holds_alternative<string_view>(value_)) {
+        return std::get<string_view>(value_);
+    }
+    return AsString();
+}
     
     
 const Array& Node::AsArray() const {
@@ -371,8 +545,77 @@ const Node& Document::GetRoot() const {
 }
 
     
+InputBuffer::InputBuffer(istream& input) {
+#ifdef JSON_MMAP_INPUT
+    if (&input == &cin && MapStdin()) {
+        return;
+    }
+#endif
+    const auto buffer = input.rdbuf();
+    for (char chunk[1 << 16]; ;) {
+        const streamsize count = buffer->sgetn(chunk, sizeof(chunk));
+        text_.append(chunk, static_cast<size_t>(count));
+        if (count < static_cast<streamsize>(sizeof(chunk))) {
+            break;
+        }
+    }
+    view_ = text_;
+}
+
+
+InputBuffer::~InputBuffer() {
+#ifdef JSON_MMAP_INPUT
+    if (mapped_ != nullptr) {
+        munmap(mapped_, mapped_size_);
+    }
+#endif
+}
+
+
+// Map rest of stdin if it is a regular file, stdin position is moved to its end like after reading
+bool InputBuffer::MapStdin() {
+#ifdef JSON_MMAP_INPUT
+    struct stat file_stat;
+    const long offset = ftell(stdin);
+    if (offset < 0 || fstat(STDIN_FILENO, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)
+        || file_stat.st_size <= offset) {
+        return false;
+    }
+    void* const mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, file_stat.st_size, MADV_SEQUENTIAL);
+    mapped_ = mapped;
+    mapped_size_ = file_stat.st_size;
+    view_ = string_view(static_cast<const char*>(mapped) + offset, mapped_size_ - offset);
+    fseek(stdin, 0, SEEK_END);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
 Document Load(istream& input) {
-    return Document{LoadNode(input)};
+    const InputBuffer buffer(input);
+    return Load(buffer.GetText());
+}
+
+
+Document Load(string_view text) {
+    return Document{Parser(text, StringStorage::COPY).LoadNode()};
+}
+
+
+void Parse(istream& input, Handler& handler) {
+    const InputBuffer buffer(input);
+    Parse(buffer.GetText(), handler);
+}
+
+
+void Parse(string_view text, Handler& handler, StringStorage strings) {
+    Parser(text, strings).ParseNode(handler);
 }
     
 
@@ -384,7 +627,7 @@ void PrintValue(bool value, std::ostream& out) {
 
     
 // Шаблон, подходящий для вывода bool
-void PrintValue(const string &value, std::ostream& out) {
+void PrintValue(std::string_view value, std::ostream& out) {
         out << "\""s;
         for (const auto& ch : value) { // Escape-symbols converter
             switch (ch) {
@@ -411,15 +654,20 @@ void PrintValue(const string &value, std::ostream& out) {
 }
     
     
-// Шаблон, подходящий для вывода double
+// Шаблон, подходящий для вывода double.
+// Самая короткая запись, которая читается обратно в то же значение, без учёта локали
 void PrintValue(double value, std::ostream& out) {
-    out << value;
+    char buffer[32];
+    const auto result = to_chars(buffer, buffer + sizeof(buffer), value);
+    out.write(buffer, result.ptr - buffer);
 }
 
 
 // Шаблон, подходящий для вывода int
 void PrintValue(int value, std::ostream& out) {
-    out << value;
+    char buffer[16];
+    const auto result = to_chars(buffer, buffer + sizeof(buffer), value);
+    out.write(buffer, result.ptr - buffer);
 }
 
     
@@ -477,8 +725,7 @@ void Print(const Document& doc, std::ostream& output) {
     
     
 json::Document LoadJSON(const std::string& s) {
-    std::istringstream strm(s);
-    return json::Load(strm);
+    return json::Load(std::string_view(s));
 }
 
     
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <sstream>
@@ -26,7 +27,8 @@ public:
     
     /* Реализуйте Node, используя std::variant */
     // std::variant<...>
-    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
+    // string_view is a string parsed with StringStorage::VIEW, it points into parsed text
+    using Value = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, std::string_view>;
     
     Node() : value_(nullptr) {}
     Node(nullptr_t ptr) : value_(ptr) {}
@@ -39,6 +41,7 @@ public:
     Node(int value) : value_(value) {};
     Node(double value) : value_(value) {};
     Node(std::string value);
+    explicit Node(std::string_view value) : value_(value) {};
     
     // std::variant<...>
     const Value& GetValue() const;
@@ -46,7 +49,7 @@ public:
     bool IsDouble() const; // Returns true, if in Node holds int or double.
     bool IsPureDouble() const; // Returns true, if in Node holds double. 
     bool IsBool() const;
-    bool IsString() const;
+    bool IsString() const; // Returns true, if in Node holds string or string_view.
     bool IsNull() const;
     bool IsArray() const;
     bool IsMap() const;
@@ -54,7 +57,8 @@ public:
     int AsInt() const;
     bool AsBool() const;
     double AsDouble() const;
-    const std::string& AsString() const;
+    const std::string& AsString() const; // Only for own string, not for string_view
+    std::string_view AsStringView() const; // For both string and string_view
     const Array& AsArray() const;
     const Dict& AsMap() const;
     
@@ -95,11 +99,72 @@ private:
     
 }; // End of class Document
 
+
+// Whole input in one contiguous block: stdin redirected from a regular file is mapped into memory,
+// any other stream is read into one string. Text stays alive until the buffer is destroyed
+class InputBuffer {
+public:
+    explicit InputBuffer(std::istream& input);
+
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    ~InputBuffer();
+
+    std::string_view GetText() const {
+        return view_;
+    }
+
+private:
+    bool MapStdin();
+
+    void* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string text_;
+    std::string_view view_;
+};
+
+
+// How parser stores strings: own copies, or string_views into parsed text for strings without escapes.
+// Views are valid only while parsed text is alive
+enum class StringStorage {
+    COPY,
+    VIEW
+};
+
+// Receives events of JSON document while it is parsed (SAX-style), parser doesn't keep the document.
+// Scalar values (null, bool, int, double, string) come to Value()
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void StartDict() = 0;
+    virtual void Key(std::string key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void Value(Node value) = 0;
+};
+
     
+// Whole input is read into memory at once (stdin redirected from a file is mapped) and parsed from buffer
 Document Load(std::istream& input);
+Document Load(std::string_view text);
+
+// Parse one JSON value from input and pass its events to handler in order of text
+void Parse(std::istream& input, Handler& handler);
+void Parse(std::string_view text, Handler& handler, StringStorage strings = StringStorage::COPY);
     
 void Print(const Document& doc, std::ostream& output);
-    
+
+// Single values in the format of Print, they are used by Writer too
+void PrintNode(const Node& node, std::ostream& out);
+void PrintValue(std::nullptr_t, std::ostream& out);
+void PrintValue(bool value, std::ostream& out);
+void PrintValue(int value, std::ostream& out);
+void PrintValue(double value, std::ostream& out);
+void PrintValue(std::string_view value, std::ostream& out);
+
 Document LoadJSON(const std::string& s); 
 
 std::string Print(const Node& node);
@@ -0,0 +1,281 @@
+#include "json_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace json {
+
+namespace {
+
+// Sizes of strings and containers are kept in 32 bits
+uint32_t CheckSize(size_t size) {
+    if (size > numeric_limits<uint32_t>::max()) {
+        throw ParsingError("JSON value is too large"s);
+    }
+    return static_cast<uint32_t>(size);
+}
+
+
+// Handler building ArenaDocument from parse events.
+// Items of open containers are collected on one stack, finished container is copied into the arena
+// as a flat array of exact size, so the stack is the only growing buffer
+class ArenaBuilder final : public Handler {
+public:
+    explicit ArenaBuilder(pmr::memory_resource& arena) : arena_(arena) {}
+
+    void StartDict() override {
+        StartContainer();
+    }
+
+    void Key(string key) override {
+        key_ = CopyString(key);
+    }
+
+    void EndDict() override {
+        const size_t begin = frames_.back();
+        const size_t size = items_.size() - begin;
+        // std::map keeps the first of equal keys, stable sort and unique do the same
+        stable_sort(items_.begin() + begin, items_.end(), [](const ArenaMember& lhs, const ArenaMember& rhs) {
+            return lhs.first < rhs.first;
+        });
+        const auto unique_end = unique(items_.begin() + begin, items_.end(), [](const ArenaMember& lhs, const ArenaMember& rhs) {
+            return lhs.first == rhs.first;
+        });
+        const size_t unique_size = unique_end - (items_.begin() + begin);
+
+        auto* const members = Allocate<ArenaMember>(unique_size);
+        uninitialized_copy(items_.begin() + begin, unique_end, members);
+        EndContainer(ArenaNode(members, unique_size), size);
+    }
+
+    void StartArray() override {
+        StartContainer();
+    }
+
+    void EndArray() override {
+        const size_t begin = frames_.back();
+        const size_t size = items_.size() - begin;
+        auto* const items = Allocate<ArenaNode>(size);
+        for (size_t i = 0; i < size; ++i) {
+            new (items + i) ArenaNode(items_[begin + i].second);
+        }
+        EndContainer(ArenaNode(items, size), size);
+    }
+
+    void Value(Node value) override {
+        AddValue(MakeNode(value));
+    }
+
+    // Root value, it is stored in the arena too
+    const ArenaNode* GetRoot() const {
+        if (!root_) {
+            throw ParsingError("Document is empty"s);
+        }
+        return root_;
+    }
+
+private:
+    template <typename T>
+    T* Allocate(size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        return static_cast<T*>(arena_.allocate(count * sizeof(T), alignof(T)));
+    }
+
+    string_view CopyString(string_view value) {
+        char* const chars = Allocate<char>(value.size());
+        if (!value.empty()) {
+            memcpy(chars, value.data(), value.size());
+        }
+        return {chars, value.size()};
+    }
+
+    // Strings which are views are left in input text, others are copied into the arena
+    ArenaNode MakeNode(const Node& value) {
+        const auto& variant = value.GetValue();
+        if (holds_alternative<nullptr_t>(variant)) {
+            return ArenaNode();
+        } else if (holds_alternative<bool>(variant)) {
+            return ArenaNode(get<bool>(variant));
+        } else if (holds_alternative<int>(variant)) {
+            return ArenaNode(get<int>(variant));
+        } else if (holds_alternative<double>(variant)) {
+            return ArenaNode(get<double>(variant));
+        } else if (holds_alternative<string_view>(variant)) {
+            return ArenaNode(get<string_view>(variant));
+        } else if (holds_alternative<string>(variant)) {
+            return ArenaNode(CopyString(get<string>(variant)));
+        }
+        throw ParsingError("Unexpected value"s);
+    }
+
+    void StartContainer() {
+        frames_.push_back(items_.size());
+        keys_.push_back(key_);
+        key_ = {};
+    }
+
+    void EndContainer(ArenaNode node, size_t size) {
+        items_.resize(items_.size() - size);
+        frames_.pop_back();
+        key_ = keys_.back();
+        keys_.pop_back();
+        AddValue(node);
+    }
+
+    void AddValue(ArenaNode node) {
+        if (frames_.empty()) {
+            root_ = new (Allocate<ArenaNode>(1)) ArenaNode(node);
+            return;
+        }
+        items_.push_back({key_, node});
+    }
+
+    pmr::memory_resource& arena_;
+    const ArenaNode* root_ = nullptr;
+
+    // Items of all open containers, key is empty for array items
+    vector<ArenaMember> items_;
+    // Position of the first item of every open container in items_
+    vector<size_t> frames_;
+    // Key of every open container in its parent
+    vector<string_view> keys_;
+    string_view key_;
+};
+
+}  // namespace
+
+
+const ArenaNode& ArenaArray::at(size_t index) const {
+    if (index >= size_) {
+        throw out_of_range("Array index is out of range"s);
+    }
+    return begin_[index];
+}
+
+
+const ArenaMember* ArenaDict::find(string_view key) const {
+    const auto it = lower_bound(begin(), end(), key, [](const ArenaMember& member, string_view key) {
+        return member.first < key;
+    });
+    return it != end() && it->first == key ? it : end();
+}
+
+
+const ArenaNode& ArenaDict::at(string_view key) const {
+    const auto it = find(key);
+    if (it == end()) {
+        throw out_of_range("No key "s + string(key));
+    }
+    return it->second;
+}
+
+
+ArenaNode::ArenaNode(string_view value)
+    : type_(Type::STRING)
+    , size_(CheckSize(value.size()))
+    , chars_(value.data()) {
+}
+
+
+ArenaNode::ArenaNode(const ArenaNode* items, size_t size)
+    : type_(Type::ARRAY)
+    , size_(CheckSize(size))
+    , items_(items) {
+}
+
+
+ArenaNode::ArenaNode(const ArenaMember* members, size_t size)
+    : type_(Type::DICT)
+    , size_(CheckSize(size))
+    , members_(members) {
+}
+
+
+int ArenaNode::AsInt() const {
+    if (!IsInt()) {
+        throw logic_error("It's not Int"s);
+    }
+    return int_;
+}
+
+
+bool ArenaNode::AsBool() const {
+    if (!IsBool()) {
+        throw logic_error("It's not Bool"s);
+    }
+    return bool_;
+}
+
+
+// Возвращает значение типа double, если внутри хранится double либо int.
+double ArenaNode::AsDouble() const {
+    if (IsInt()) {
+        return int_;
+    }
+    if (IsPureDouble()) {
+        return double_;
+    }
+    throw logic_error("It's not Double"s);
+}
+
+
+string_view ArenaNode::AsString() const {
+    if (!IsString()) {
+        throw logic_error("It's not String"s);
+    }
+    return {chars_, size_};
+}
+
+
+ArenaArray ArenaNode::AsArray() const {
+    if (!IsArray()) {
+        throw logic_error("It's not Array"s);
+    }
+    return {items_, size_};
+}
+
+
+ArenaDict ArenaNode::AsMap() const {
+    if (!IsMap()) {
+        throw logic_error("It's not Map"s);
+    }
+    return {members_, size_};
+}
+
+
+ArenaDocument::ArenaDocument(istream& input)
+    : input_(make_unique<InputBuffer>(input)) {
+    Build(input_->GetText());
+}
+
+
+// Text is copied into the arena, so the document doesn't depend on it
+ArenaDocument::ArenaDocument(string_view text) {
+    arena_ = make_unique<pmr::monotonic_buffer_resource>(text.size() * 2 + 1024);
+    char* const chars = static_cast<char*>(arena_->allocate(text.size() + 1, 1));
+    memcpy(chars, text.data(), text.size());
+    Build({chars, text.size()});
+}
+
+
+void ArenaDocument::Build(string_view text) {
+    // Containers take about as much memory as their text
+    if (!arena_) {
+        arena_ = make_unique<pmr::monotonic_buffer_resource>(text.size() + 1024);
+    }
+    ArenaBuilder builder(*arena_);
+    Parse(text, builder, StringStorage::VIEW);
+    root_ = builder.GetRoot();
+}
+
+}  // namespace json
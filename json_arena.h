@@ -0,0 +1,198 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+class ArenaArray;
+class ArenaDict;
+struct ArenaMember;
+
+// Value of ArenaDocument: 16 bytes, containers and strings point into the arena or into input text
+class ArenaNode {
+public:
+    enum class Type : std::uint8_t {
+        NULL_VALUE,
+        ARRAY,
+        DICT,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING
+    };
+
+    ArenaNode() : type_(Type::NULL_VALUE), size_(0), items_(nullptr) {}
+    explicit ArenaNode(bool value) : type_(Type::BOOL), size_(0), bool_(value) {}
+    explicit ArenaNode(int value) : type_(Type::INT), size_(0), int_(value) {}
+    explicit ArenaNode(double value) : type_(Type::DOUBLE), size_(0), double_(value) {}
+    explicit ArenaNode(std::string_view value);
+    ArenaNode(const ArenaNode* items, size_t size);
+    ArenaNode(const ArenaMember* members, size_t size);
+
+    Type GetType() const {
+        return type_;
+    }
+
+    bool IsInt() const {
+        return type_ == Type::INT;
+    }
+
+    // Returns true, if in Node holds int or double.
+    bool IsDouble() const {
+        return type_ == Type::INT || type_ == Type::DOUBLE;
+    }
+
+    // Returns true, if in Node holds double.
+    bool IsPureDouble() const {
+        return type_ == Type::DOUBLE;
+    }
+
+    bool IsBool() const {
+        return type_ == Type::BOOL;
+    }
+
+    bool IsString() const {
+        return type_ == Type::STRING;
+    }
+
+    bool IsNull() const {
+        return type_ == Type::NULL_VALUE;
+    }
+
+    bool IsArray() const {
+        return type_ == Type::ARRAY;
+    }
+
+    bool IsMap() const {
+        return type_ == Type::DICT;
+    }
+
+    int AsInt() const;
+    bool AsBool() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    std::string_view AsStringView() const {
+        return AsString();
+    }
+    ArenaArray AsArray() const;
+    ArenaDict AsMap() const;
+
+private:
+    Type type_;
+    std::uint32_t size_;
+    union {
+        bool bool_;
+        int int_;
+        double double_;
+        const char* chars_;
+        const ArenaNode* items_;
+        const ArenaMember* members_;
+    };
+};
+
+
+// Member of ArenaDict, names are the same as of Dict items
+struct ArenaMember {
+    std::string_view first;
+    ArenaNode second;
+};
+
+
+// Read-only array of ArenaDocument, items lie one after another in the arena
+class ArenaArray {
+public:
+    ArenaArray(const ArenaNode* begin, size_t size) : begin_(begin), size_(size) {}
+
+    const ArenaNode* begin() const {
+        return begin_;
+    }
+
+    const ArenaNode* end() const {
+        return begin_ + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const ArenaNode& operator[](size_t index) const {
+        return begin_[index];
+    }
+
+    const ArenaNode& at(size_t index) const;
+
+private:
+    const ArenaNode* begin_;
+    size_t size_;
+};
+
+
+// Read-only object of ArenaDocument: flat array of members sorted by key, keys are unique.
+// Access is the same as for Dict (std::map): at, count, find, iteration in order of keys
+class ArenaDict {
+public:
+    ArenaDict(const ArenaMember* begin, size_t size) : begin_(begin), size_(size) {}
+
+    const ArenaMember* begin() const {
+        return begin_;
+    }
+
+    const ArenaMember* end() const {
+        return begin_ + size_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Member with key or end()
+    const ArenaMember* find(std::string_view key) const;
+
+    size_t count(std::string_view key) const {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    const ArenaNode& at(std::string_view key) const;
+
+private:
+    const ArenaMember* begin_;
+    size_t size_;
+};
+
+
+// Parsed JSON document which owns its input text and one arena with all arrays, objects and escaped strings.
+// Building and destroying it costs a few large allocations instead of one per value.
+// The document can't be changed, it is used to read requests
+class ArenaDocument {
+public:
+    explicit ArenaDocument(std::istream& input);
+    explicit ArenaDocument(std::string_view text);
+
+    const ArenaNode& GetRoot() const {
+        return *root_;
+    }
+
+private:
+    void Build(std::string_view text);
+
+    std::unique_ptr<InputBuffer> input_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    const ArenaNode* root_ = nullptr;
+};
+
+}  // namespace json
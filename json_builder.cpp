@@ -7,52 +7,34 @@ namespace json {
 
 // -----  Class Builder  ----- //
 
-// Process input value
+// Process input value, it is moved into its place in the tree without copies
 Builder& Builder::Value(Node::Value&& value) {
     if (nodes_stack_.size() == 0) {
         throw std::logic_error("Call Value() after ready object");
     }
 
-    Node node;
-    if (std::holds_alternative<nullptr_t>(value)) {
-        node = Node(std::get<0>(value));
-    } else if (std::holds_alternative<Array>(value)) {
-        node = Node(std::get<1>(value));
-    } else if (std::holds_alternative<Dict>(value)) {
-        node = Node(std::get<2>(value));
-    } else if (std::holds_alternative<bool>(value)) {
-        node = Node(std::get<3>(value));
-    } else if (std::holds_alternative<int>(value)) {
-        node = Node(std::get<4>(value));
-    } else if(std::holds_alternative<double>(value)) {
-        node = Node(std::get<5>(value));
-    } else if (std::holds_alternative<std::string>(value)) {
-        node = Node(std::get<6>(value));
-    }
-    
-    auto &curr_node = nodes_stack_.back(); 
+    Node* curr_node = nodes_stack_.back();
+    Node* node = nullptr;
     if (curr_node->IsArray()) {
-        std::get<1>(curr_node->GetRefValue()).push_back(node);
-        if (node.IsArray()|| node.IsMap()) {
-            nodes_stack_.push_back(&std::get<1>(curr_node->GetRefValue()).back());
-        }
+        node = &std::get<Array>(curr_node->GetRefValue()).emplace_back();
     } else if (curr_node->IsMap()) {
         if (key_used_) {
             throw std::logic_error("Invalid use of Value()");
         }
-        std::get<2>(curr_node->GetRefValue())[key_] = node;
+        node = &std::get<Dict>(curr_node->GetRefValue())[std::move(key_)];
         key_used_ = true;
-        if (node.IsArray() || node.IsMap()) {
-            nodes_stack_.push_back(&std::get<2>(curr_node->GetRefValue()).at(key_));
-        }
         key_.clear();
-
     } else {
-        root_ = node;
+        node = &root_;
+    }
+
+    node->GetRefValue() = std::move(value);
+    if (node == &root_) {
         if (!root_.IsArray() && !root_.IsMap()) {
             nodes_stack_.pop_back();
         }
-
+    } else if (node->IsArray() || node->IsMap()) {
+        nodes_stack_.push_back(node);
     }
     return *this;
 }
@@ -65,6 +47,15 @@ const Node& Builder::Build() const {
     }
     return root_;
 }
+
+
+// Move ready object out of builder, checks are the same as of Build()
+Node Builder::Extract() {
+    if (nodes_stack_.size() > 0 && !root_.IsArray() && !root_.IsMap()) {
+        throw std::logic_error("Invalid use of Extract()");
+    }
+    return std::move(root_);
+}
   
     
 // Get a key for Dict  
@@ -114,6 +105,14 @@ AferStartArrayContext Builder::StartArray() {
     this->Value(Array{});
     return AferStartArrayContext(*this);
 }
+
+
+// Add Array for filling with place for size items
+AferStartArrayContext Builder::StartArray(size_t size) {
+    StartArray();
+    std::get<Array>(nodes_stack_.back()->GetRefValue()).reserve(size);
+    return AferStartArrayContext(*this);
+}
     
 
 // End filling Array
@@ -151,6 +150,10 @@ AferStartArrayContext ItemContext::StartArray() {
     return builder_.StartArray();
 }
 
+AferStartArrayContext ItemContext::StartArray(size_t size) {
+    return builder_.StartArray(size);
+}
+
 
 // -----  Class KeyItemContext  ----- //
 
@@ -16,12 +16,17 @@ public:
         nodes_stack_.push_back(&root_);
     }
     
+    // Value is moved into the tree, string_view is kept as view and its text must outlive the Node
     Builder& Value(Node::Value&& value);
     const Node& Build() const;
+    // Ready object without copy, builder can't be used after it
+    Node Extract();
     KeyItemContext Key(std::string);
     DictItemContext StartDict();
     Builder& EndDict();
     AferStartArrayContext StartArray();
+    // Array with memory reserved for size items
+    AferStartArrayContext StartArray(size_t size);
     Builder& EndArray();
     
 private:
@@ -40,6 +45,7 @@ public:
 
     DictItemContext StartDict();
     AferStartArrayContext StartArray();
+    AferStartArrayContext StartArray(size_t size);
 
 protected:
     Builder& builder_;
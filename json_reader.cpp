@@ -1,79 +1,278 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "json_writer.h"
 #include <iostream>
+#include <stdexcept>
 #include "transport_router.h"
+#include "parallel.h"
+#include <algorithm>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <tuple>
 
 using namespace std;
 
-// Adds info about Stop from using Dict = std::map<std::string, Node>; into catalogue
-void AddStopIntoCatalogue(TransportCatalogue& catalogue, const Dict& stop_description_map, DstBetwStops& dist_to_stop) {
-    double latitude = stop_description_map.at("latitude"s).AsDouble();
-    double longitude = stop_description_map.at("longitude"s).AsDouble();
-    std::string stop_name = stop_description_map.at("name"s).AsString();
-    if (stop_description_map.count("road_distances"s) > 0) {
-        dist_to_stop[stop_name] = stop_description_map.at("road_distances"s).AsMap();
-    }
-
-    catalogue.AddNewStop(std::move(stop_name), { latitude, longitude });
-}
-
-
 // Adds info about Bus from using Dict = std::map<std::string, Node>; into catalogue
 void AddBusIntoCatalogue(TransportCatalogue& catalogue, const Dict& bus_description_map) {
-    vector<string> stops;
+    vector<string_view> stops;
     const vector<Node>& ref_vector = bus_description_map.at("stops"s).AsArray();
     stops.reserve(ref_vector.size() * 2);
 
     // Add straight route into stops from 1-st to 2-nd stop
     for (auto& stop : ref_vector) {
-        stops.push_back(stop.AsString());
+        stops.push_back(stop.AsStringView());
     }
 
     // Add stops into vec-stops in reverse range if route isn't round
     if (!bus_description_map.at("is_roundtrip"s).AsBool()) {
         for (int i = static_cast<int>(ref_vector.size()) - 2; i >= 0; --i) {
-            stops.push_back(ref_vector.at(i).AsString());
+            stops.push_back(ref_vector.at(i).AsStringView());
         }
     }
-    catalogue.AddNewBus(bus_description_map.at("name"s).AsString(), stops, bus_description_map.at("is_roundtrip"s).AsBool());
+    catalogue.AddNewBus(bus_description_map.at("name"s).AsStringView(), stops, bus_description_map.at("is_roundtrip"s).AsBool());
 }
 
 
-// Get info about Buses and Stops from struct Document and add it into TransportCatalogue
-void FillTransportCatalogue(TransportCatalogue& catalogue, const Document& document) {
-    const auto& json_map = document.GetRoot().AsMap();
+// Get routing engine type from its name in routing_settings
+RouterType GetRouterTypeFromName(const std::string& router_name) {
+    if (router_name == "floyd_warshall"s) {
+        return RouterType::FLOYD_WARSHALL;
+    }
+    if (router_name == "dijkstra"s) {
+        return RouterType::DIJKSTRA;
+    }
+    if (router_name == "contraction_hierarchy"s) {
+        return RouterType::CONTRACTION_HIERARCHY;
+    }
+    throw std::invalid_argument("Unknown router: "s + router_name);
+}
+
+
+// Get route graph model from its name in routing_settings
+RouteGraphModel GetRouteGraphModelFromName(const std::string& model_name) {
+    if (model_name == "complete"s) {
+        return RouteGraphModel::COMPLETE;
+    }
+    if (model_name == "compact"s) {
+        return RouteGraphModel::COMPACT;
+    }
+    throw std::invalid_argument("Unknown graph model: "s + model_name);
+}
+
+
+// Set routing_settings into catalogue
+void FillRoutingSettings(TransportCatalogue& catalogue, const Dict& route_settings) {
+    catalogue.SetBusVelocity(route_settings.at("bus_velocity"s).AsDouble());
+    catalogue.SetBusWaitTime(route_settings.at("bus_wait_time"s).AsInt());
+    if (route_settings.count("router"s) > 0) {
+        catalogue.SetRouterType(GetRouterTypeFromName(route_settings.at("router"s).AsString()));
+    }
+    if (route_settings.count("graph_model"s) > 0) {
+        catalogue.SetRouteGraphModel(GetRouteGraphModelFromName(route_settings.at("graph_model"s).AsString()));
+    }
+}
+
+
+namespace {
+
+// Handler filling catalogue while make_base document is parsed.
+// Every element of base_requests and every other top-level value is collected into a Node by Builder,
+// then base request is added into catalogue and dropped. Only data referring to not yet added stops is kept:
+// distances to unknown stops and buses (all next buses too, so buses keep their order)
+class CatalogueLoader final : public json::Handler {
+public:
+    explicit CatalogueLoader(TransportCatalogue& catalogue) : catalogue_(catalogue) {}
+
+    void StartDict() override {
+        StartContainer(true);
+    }
+
+    void Key(std::string key) override {
+        if (builder_) {
+            builder_->Key(std::move(key));
+        } else if (depth_ == 1) {
+            top_key_ = std::move(key);
+        } else {
+            throw std::invalid_argument("Unexpected key "s + key);
+        }
+    }
+
+    void EndDict() override {
+        EndContainer(true);
+    }
 
-    // Store Stop to Stop Distance Map which will process
-    DstBetwStops dist_to_stop;
+    void StartArray() override {
+        StartContainer(false);
+    }
+
+    void EndArray() override {
+        EndContainer(false);
+    }
 
-    // Process all Stops
-    for (const auto& node : json_map.at("base_requests"s).AsArray()) {
-        const Dict& base_content = node.AsMap();
-        if (base_content.at("type"s) == "Stop"s) {
-            AddStopIntoCatalogue(catalogue, base_content, dist_to_stop);
+    void Value(Node value) override {
+        // Settings outlive parsed text, base requests are used while it is alive
+        if (!in_base_requests_ && std::holds_alternative<std::string_view>(value.GetValue())) {
+            value = Node(std::string(value.AsStringView()));
+        }
+        if (builder_) {
+            builder_->Value(std::move(value.GetRefValue()));
+        } else if (depth_ == 1) {
+            settings_[top_key_] = std::move(value);
+        } else {
+            throw std::invalid_argument("Base request should be Dict"s);
         }
     }
 
-    // Process Stop To Stop Distances
-    for (const auto& [stop_from, next_stop] : dist_to_stop) {
-        for (const auto& [stop_to, dist] : next_stop) {
-            catalogue.AddDstBetweenStops(stop_from, dist.AsInt(), stop_to);
+    // Add data waiting for stops which never came and get all top-level values except base_requests
+    Dict Finish() {
+        for (const auto& [stop_from, dist, stop_to] : pending_distances_) {
+            catalogue_.AddDstBetweenStops(stop_from, dist, stop_to);
+        }
+        pending_distances_.clear();
+        for (const auto& bus : pending_buses_) {
+            AddBusIntoCatalogue(catalogue_, bus);
         }
+        pending_buses_.clear();
+        return std::move(settings_);
     }
 
-    // Process all Buses
-    for (const auto& node : json_map.at("base_requests"s).AsArray()) {
-        const Dict& base_content = node.AsMap();
-        if (base_content.at("type"s) == "Bus"s) {
-            AddBusIntoCatalogue(catalogue, base_content);
+private:
+    void StartContainer(bool is_dict) {
+        ++depth_;
+        if (builder_) {
+            StartBuilderContainer(is_dict);
+        } else if (depth_ == 2 && top_key_ == "base_requests"s && !is_dict) {
+            in_base_requests_ = true;
+        } else if (depth_ == 2 || (depth_ == 3 && in_base_requests_)) {
+            builder_.emplace();
+            builder_depth_ = depth_;
+            StartBuilderContainer(is_dict);
+        } else if (depth_ != 1 || !is_dict) {
+            throw std::invalid_argument("Unexpected structure of make_base document"s);
         }
     }
 
+    void StartBuilderContainer(bool is_dict) {
+        if (is_dict) {
+            builder_->StartDict();
+        } else {
+            builder_->StartArray();
+        }
+    }
 
-    const auto& route_settings = json_map.at("routing_settings"s).AsMap();
-    catalogue.SetBusVelocity(route_settings.at("bus_velocity"s).AsDouble());
-    catalogue.SetBusWaitTime(route_settings.at("bus_wait_time"s).AsInt());
-    
+    void EndContainer(bool is_dict) {
+        if (builder_) {
+            is_dict ? builder_->EndDict() : builder_->EndArray();
+            if (depth_ == builder_depth_) {
+                Node node = builder_->Extract();
+                builder_.reset();
+                if (in_base_requests_) {
+                    AddBaseRequest(std::move(std::get<Dict>(node.GetRefValue())));
+                } else {
+                    settings_[top_key_] = std::move(node);
+                }
+            }
+        } else if (depth_ == 2 && in_base_requests_) {
+            in_base_requests_ = false;
+        }
+        --depth_;
+    }
+
+    bool IsKnownStop(std::string_view stop_name) const {
+        return catalogue_.FindStopId(stop_name).has_value();
+    }
+
+    void AddBaseRequest(Dict&& request) {
+        const auto type = request.at("type"s).AsStringView();
+        if (type == "Stop"sv) {
+            AddStop(request);
+        } else if (type == "Bus"sv) {
+            AddBus(std::move(request));
+        }
+    }
+
+    // Stop name is copied once into catalogue, distances are added by views
+    void AddStop(const Dict& request) {
+        const auto stop_name = request.at("name"s).AsStringView();
+        catalogue_.AddNewStop(stop_name, { request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble() });
+        if (const auto it = request.find("road_distances"s); it != request.end()) {
+            for (const auto& [stop_to, dist] : it->second.AsMap()) {
+                if (IsKnownStop(stop_to)) {
+                    catalogue_.AddDstBetweenStops(stop_name, dist.AsInt(), stop_to);
+                } else {
+                    pending_distances_.emplace_back(std::string(stop_name), dist.AsInt(), stop_to);
+                }
+            }
+        }
+
+        // New stop may be the last one some buses wait for
+        while (!pending_buses_.empty() && IsBusReady(pending_buses_.front())) {
+            AddBusIntoCatalogue(catalogue_, pending_buses_.front());
+            pending_buses_.pop_front();
+        }
+    }
+
+    // Bus which waits for its stops is moved into queue
+    void AddBus(Dict&& request) {
+        if (pending_buses_.empty() && IsBusReady(request)) {
+            AddBusIntoCatalogue(catalogue_, request);
+        } else {
+            pending_buses_.push_back(std::move(request));
+        }
+    }
+
+    bool IsBusReady(const Dict& request) const {
+        const auto& stops = request.at("stops"s).AsArray();
+        return std::all_of(stops.begin(), stops.end(), [this](const Node& stop) {
+            return IsKnownStop(stop.AsStringView());
+        });
+    }
+
+    TransportCatalogue& catalogue_;
+    Dict settings_;
+
+    size_t depth_ = 0;
+    std::string top_key_;
+    bool in_base_requests_ = false;
+
+    // Builder of current base request or top-level value
+    std::optional<Builder> builder_;
+    size_t builder_depth_ = 0;
+
+    std::vector<std::tuple<std::string, int, std::string>> pending_distances_;
+    // String values of pending buses are views into parsed text
+    std::deque<Dict> pending_buses_;
+};
+
+} // namespace
+
+
+// Read make_base document in one pass and fill catalogue.
+// Strings of base_requests are views into input buffer, only names stored by catalogue are copied
+Document StreamTransportCatalogue(TransportCatalogue& catalogue, std::istream& input) {
+    const json::InputBuffer buffer(input);
+    CatalogueLoader loader(catalogue);
+    json::Parse(buffer.GetText(), loader, json::StringStorage::VIEW);
+    Document settings(loader.Finish());
+
+    FillRoutingSettings(catalogue, settings.GetRoot().AsMap().at("routing_settings"s).AsMap());
+    return settings;
+}
+
+
+// Get route cache size in bytes from optional route_cache_settings of process_requests
+template <typename JsonDocument>
+size_t GetRouteCacheSize(const JsonDocument& document) {
+    const auto& json_map = document.GetRoot().AsMap();
+    if (json_map.count("route_cache_settings"s) == 0) {
+        return 0;
+    }
+    const int max_bytes = json_map.at("route_cache_settings"s).AsMap().at("max_bytes"s).AsInt();
+    if (max_bytes < 0) {
+        throw std::invalid_argument("Route cache size should be non-negative"s);
+    }
+    return static_cast<size_t>(max_bytes);
 }
 
 /* ///// **** END FILL DATA INTO CATALOGUE ****///// */
@@ -108,26 +307,24 @@ Node ParseStopAnswer(TransportCatalogue& catalogue, const Dict& request) {
 */
 
 
-// New version of ParseStopAnswer - class Builder() exists
-Node ParseStopAnswer(TransportCatalogue& catalogue, const Dict& request) {
-    const Stop& stop = catalogue.FindStop(request.at("name"s).AsString());
-    json::Builder build_answer;
-    build_answer.StartDict().Key("request_id"s).Value(request.at("id"s).AsInt());
+// Answers are written by json::Writer, keys go in order of Dict, so text is the same as of printed Node
+template <typename Request>
+void ParseStopAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Request& request) {
+    const auto stop = catalogue.FindStopId(request.at("name"s).AsString());
+    answer.StartDict();
 
-    if (stop.IsEmtyStop()) {
-        build_answer.Key("error_message"s).Value("not found"s).EndDict();
-        return build_answer.Build();
+    if (!stop) {
+        answer.Key("error_message"sv).Value("not found"sv);
     }
     else {
-        const std::set<std::string_view>& all_stops = catalogue.FindBusesAtStop(stop.stop_name);
-
-        build_answer.Key("buses"s).StartArray();
-        for (auto& stop : all_stops) {
-            build_answer.Value(std::string(stop));
+        answer.Key("buses"sv).StartArray();
+        for (const auto& bus : catalogue.FindBusesAtStop(*stop)) {
+            answer.Value(bus);
         }
-
-        return build_answer.EndArray().EndDict().Build();
+        answer.EndArray();
     }
+
+    answer.Key("request_id"sv).Value(request.at("id"s).AsInt()).EndDict();
 }
 
 
@@ -157,29 +354,26 @@ Node ParseBusAnswer(const TransportCatalogue& catalogue, const Dict& request) {
 */
 
 
-// New version of ParseBusAnswer - class Builder() exists
-Node ParseBusAnswer(const TransportCatalogue& catalogue, const Dict& request) {
-    Builder build_answer;
-    build_answer.StartDict().Key("request_id"s).Value(request.at("id"s).AsInt());
-    const vector<string_view>& bus = catalogue.FindBus(request.at("name"s).AsString());
+template <typename Request>
+void ParseBusAnswer(json::Writer& answer, const TransportCatalogue& catalogue, const Request& request) {
+    const int request_id = request.at("id"s).AsInt();
+    const auto bus = catalogue.FindBusId(request.at("name"s).AsString());
+    answer.StartDict();
 
     // if such bus-route doesn't exists
-    if (bus.empty()) {
-        build_answer.Key("error_message"s).Value("not found"s).EndDict();
-        return build_answer.Build();
+    if (!bus || catalogue.GetBus(*bus).bus_route.empty()) {
+        answer.Key("error_message"sv).Value("not found"sv);
+        answer.Key("request_id"sv).Value(request_id).EndDict();
+        return;
     }
 
-    // Add info about bus-route
-    build_answer.Key("stop_count"s).Value(static_cast<int>(bus.size()));
-    std::set<std::string_view> unique_stop(bus.begin(), bus.end());
-
-    build_answer.Key("unique_stop_count"s).Value(static_cast<int>(unique_stop.size()));
-    const auto distances = catalogue.ComputeRouteDistance(bus);
-
-    build_answer.Key("curvature"s).Value(static_cast<double>(distances.real_dist / distances.gps_dist));
-    build_answer.Key("route_length"s).Value(distances.real_dist).EndDict();
-
-    return build_answer.Build();
+    // Add info about bus-route, it is computed once for all requests
+    const BusStats& stats = catalogue.GetBusStats(*bus);
+    answer.Key("curvature"sv).Value(stats.curvature);
+    answer.Key("request_id"sv).Value(request_id);
+    answer.Key("route_length"sv).Value(stats.route_length);
+    answer.Key("stop_count"sv).Value(stats.stop_count);
+    answer.Key("unique_stop_count"sv).Value(stats.unique_stop_count).EndDict();
 }
 
 
@@ -202,12 +396,8 @@ Node ParseSvgBusRoute(const TransportCatalogue& catalogue, const Dict& request,
 */
 
 
-// New version of ParseSvgBusRoute - class Builder() exists
-Node ParseSvgBusRoute(const TransportCatalogue& catalogue, const Dict& request, const RenderSettings& render_settings) {
-    Builder build_answer;
-    build_answer.StartDict();
-    build_answer.Key("request_id"s).Value(request.at("id"s).AsInt());
-
+template <typename Request>
+void ParseSvgBusRoute(json::Writer& answer, const TransportCatalogue& catalogue, const Request& request, const RenderSettings& render_settings) {
     // Here we draw buses routes in SVG format using map_renderer.h
     svg::Document doc;
     std::vector<unique_ptr<svg::Drawable>> pucture = std::move(DrawBusessRoutes(render_settings, catalogue));
@@ -215,75 +405,142 @@ Node ParseSvgBusRoute(const TransportCatalogue& catalogue, const Dict& request,
     std::ostringstream o_stream;
     doc.Render(o_stream);
 
-    build_answer.Key("map"s).Value(o_stream.str()).EndDict();
-
-    return build_answer.Build();
+    answer.StartDict();
+    answer.Key("map"sv).Value(o_stream.str());
+    answer.Key("request_id"sv).Value(request.at("id"s).AsInt()).EndDict();
 }
 
 
 // Parsing route answer via creating minimal route by using SingleBusRoute class (struct)
-Node ParseRouteAnswer(const TransportCatalogue& catalogue, const Dict& request) {
-    Builder build_answer;
-    build_answer.StartDict();
-    build_answer.Key("request_id"s).Value(request.at("id"s).AsInt());
-
-    static SingleBusRoute tracker(catalogue);
+template <typename Request>
+void ParseRouteAnswer(json::Writer& answer, const SingleBusRoute& tracker, const Request& request) {
+    const int request_id = request.at("id"s).AsInt();
     const auto route = tracker.BuildRoute(request.at("from"s).AsString(), request.at("to"s).AsString());
+    answer.StartDict();
 
-    if (route.has_value()) {
-        build_answer.Key("total_time"s).Value((*route).weight);
-        build_answer.Key("items"s).StartArray();
+    if (!route.has_value()) {
+        answer.Key("error_message"sv).Value("not found"sv);
+        answer.Key("request_id"sv).Value(request_id).EndDict();
+        return;
+    }
 
-        const auto wait_time = catalogue.BusWaitTime();
-        for (size_t edge : (*route).edges) {
+    answer.Key("items"sv).StartArray();
+    for (const auto& item : tracker.GetRouteItems(*route)) {
+        if (item.bus_name.empty()) {
+            answer.StartDict().Key("stop_name"sv).Value(item.stop_name);
+            answer.Key("time"sv).Value(item.time);
+            answer.Key("type"sv).Value("Wait"sv).EndDict();
+        }
+        else {
+            answer.StartDict().Key("bus"sv).Value(item.bus_name);
+            answer.Key("span_count"sv).Value(item.span_count);
+            answer.Key("time"sv).Value(item.time);
+            answer.Key("type"sv).Value("Bus"sv).EndDict();
+        }
+    }
+    answer.EndArray();
 
-            build_answer.StartDict().Key("stop_name"s).Value(tracker.GetStopNameByEdgeId(edge));
-            build_answer.Key("time"s).Value(wait_time);
-            build_answer.Key("type"s).Value("Wait"s).EndDict();
+    answer.Key("request_id"sv).Value(request_id);
+    answer.Key("total_time"sv).Value((*route).weight).EndDict();
+}
 
-            build_answer.StartDict().Key("bus"s).Value(tracker.GetBusNameByEdgeId(edge));
-            build_answer.Key("span_count"s).Value(tracker.GetStopNumbByEdgeId(edge));
-            build_answer.Key("time"s).Value(tracker.GetEdgeWeightByEdgeId(edge) - wait_time);
-            build_answer.Key("type"s).Value("Bus"s).EndDict();
-        }
-        build_answer.EndArray();
+
+// Write answer for a single request of stat_requests, nothing is written for unknown request type
+template <typename Request>
+bool ParseRequestAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Request& request, const RequestData& data) {
+    const auto& type = request.at("type"s).AsString();
+    // Parse answer for stop-request
+    if (type == "Stop"s) {
+        ParseStopAnswer(answer, catalogue, request);
+        return true;
     }
-    else {
-        build_answer.Key("error_message"s).Value("not found"s);
+    // Parse answer for bus-request
+    if (type == "Bus"s) {
+        ParseBusAnswer(answer, catalogue, request);
+        return true;
+    }
+    if (type == "Map"s) {
+        ParseSvgBusRoute(answer, catalogue, request, data.GetRenderSettings());
+        return true;
     }
+    // Here we process "Route" request. In Future we can unify request parametres and take it into map<request_type, function> 
+    if (type == "Route"s) {
+        ParseRouteAnswer(answer, data.GetRouter(), request);
+        return true;
+    }
+    return false;
+}
 
-    build_answer.EndDict();
 
-    return build_answer.Build();
+// Get optional thread_count from execution_settings of process_requests, all cores are used by default
+template <typename JsonDocument>
+size_t GetThreadCount(const JsonDocument& document) {
+    const auto& json_map = document.GetRoot().AsMap();
+    if (json_map.count("execution_settings"s) == 0) {
+        return parallel::DefaultThreadCount();
+    }
+    const int thread_count = json_map.at("execution_settings"s).AsMap().at("thread_count"s).AsInt();
+    if (thread_count < 1) {
+        throw std::invalid_argument("Thread count should be positive"s);
+    }
+    return static_cast<size_t>(thread_count);
 }
 
 
-// Get and build all answers from stat_requests Node from readed Json file
-Node GetReaquestAnwer(TransportCatalogue& catalogue, const Document& document, const RenderSettings& render_settings) {
-    const auto& json_map = document.GetRoot().AsMap();
-    Array result_node;
-    result_node.reserve(json_map.at("stat_requests"s).AsArray().size());
-
-    for (const auto& node : json_map.at("stat_requests"s).AsArray()) {
-        const Dict& base_content = node.AsMap();
-        // Parse answer for stop-request
-        if (base_content.at("type"s).AsString() == "Stop"s) {
-            result_node.push_back(std::move(ParseStopAnswer(catalogue, base_content)));
-        }
-        // Parse answer for bus-request
-        else if (base_content.at("type"s).AsString() == "Bus"s) {
-            result_node.push_back(std::move(ParseBusAnswer(catalogue, base_content)));
-        }
-        else if (base_content.at("type"s).AsString() == "Map"s) {
-            result_node.push_back(std::move(ParseSvgBusRoute(catalogue, base_content, render_settings)));
-            // Here we process "Route" request. In Future we can unify request parametres and take it into map<request_type, function> 
-        }
-        else if (base_content.at("type"s).AsString() == "Route"s) {
-            result_node.push_back(std::move(ParseRouteAnswer(catalogue, base_content)));
+// Write answers of all stat_requests into out as one JSON array.
+// Requests only read catalogue and router, so they are processed in parallel by blocks:
+// every answer of block is written into its own string, then block goes to out in order of requests.
+// Only one block of answers is kept in memory whatever the number of requests is
+template <typename JsonDocument>
+void PrintRequestAnswers(std::ostream& out, TransportCatalogue& catalogue, const JsonDocument& document, const RequestData& data, size_t thread_count) {
+    const auto& requests = document.GetRoot().AsMap().at("stat_requests"s).AsArray();
+    json::Writer writer(out);
+    writer.StartArray();
+
+    if (thread_count <= 1) {
+        for (const auto& request : requests) {
+            ParseRequestAnswer(writer, catalogue, request.AsMap(), data);
         }
+        writer.EndArray();
+        return;
     }
 
-    return result_node;
+    const size_t block_size = thread_count * ANSWERS_PER_THREAD_IN_BLOCK;
+    std::vector<std::optional<std::string>> answers;
+    for (size_t block_begin = 0; block_begin < requests.size(); block_begin += block_size) {
+        answers.assign(std::min(block_size, requests.size() - block_begin), std::nullopt);
+
+        parallel::ForEachIndex(answers.size(), [&](size_t index) {
+            std::ostringstream answer_stream;
+            json::Writer answer(answer_stream);
+            if (ParseRequestAnswer(answer, catalogue, requests[block_begin + index].AsMap(), data)) {
+                answers[index] = answer_stream.str();
+            }
+        }, thread_count);
+
+        for (const auto& answer : answers) {
+            if (answer) {
+                writer.RawValue(*answer);
+            }
+        }
+    }
+    writer.EndArray();
 }
 
-/* ///// **** END FORM ANSWER ****///// */
\ No newline at end of file
+// Requests are read both from Document and from ArenaDocument
+template size_t GetRouteCacheSize(const Document& document);
+template size_t GetRouteCacheSize(const ArenaDocument& document);
+template void ParseStopAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Dict& request);
+template void ParseStopAnswer(json::Writer& answer, TransportCatalogue& catalogue, const ArenaDict& request);
+template void ParseBusAnswer(json::Writer& answer, const TransportCatalogue& catalogue, const Dict& request);
+template void ParseBusAnswer(json::Writer& answer, const TransportCatalogue& catalogue, const ArenaDict& request);
+template void ParseSvgBusRoute(json::Writer& answer, const TransportCatalogue& catalogue, const Dict& request, const RenderSettings& render_settings);
+template void ParseSvgBusRoute(json::Writer& answer, const TransportCatalogue& catalogue, const ArenaDict& request, const RenderSettings& render_settings);
+template void ParseRouteAnswer(json::Writer& answer, const SingleBusRoute& tracker, const Dict& request);
+template void ParseRouteAnswer(json::Writer& answer, const SingleBusRoute& tracker, const ArenaDict& request);
+template bool ParseRequestAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Dict& request, const RequestData& data);
+template bool ParseRequestAnswer(json::Writer& answer, TransportCatalogue& catalogue, const ArenaDict& request, const RequestData& data);
+template size_t GetThreadCount(const Document& document);
+template size_t GetThreadCount(const ArenaDocument& document);
+template void PrintRequestAnswers(std::ostream& out, TransportCatalogue& catalogue, const Document& document, const RequestData& data, size_t thread_count);
+template void PrintRequestAnswers(std::ostream& out, TransportCatalogue& catalogue, const ArenaDocument& document, const RequestData& data, size_t thread_count);
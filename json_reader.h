@@ -1,8 +1,14 @@
 #pragma once
 
 #include "json.h"
+#include "json_arena.h"
+#include "json_writer.h"
 #include "map_renderer.h"
 #include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <iostream>
+#include <optional>
 
 using namespace transport;
 using namespace transport::detail;
@@ -12,32 +18,74 @@ using namespace std::string_literals;
 using namespace json;
 
 
-using DstBetwStops = std::map<std::string, Dict>;
-
 /* ///// **** READS DATA FROM JSON AND FILL IT INTO CATALOGUE ****///// */
 
-// Adds info about Stop from using Dict = std::map<std::string, Node>; into catalogue
-void AddStopIntoCatalogue(TransportCatalogue& catalogue, const Dict& stop_description_map, DstBetwStops& dist_to_stop);
-
 // Adds info about Bus from using Dict = std::map<std::string, Node>; into catalogue
 void AddBusIntoCatalogue(TransportCatalogue& catalogue, const Dict& bus_description_map);
 
-// Get info about Buses and Stops from struct Document and add it into TransportCatalogue
-void FillTransportCatalogue(TransportCatalogue& catalogue, const Document& document);
+// Get routing engine type from its name in routing_settings ("floyd_warshall", "dijkstra" or "contraction_hierarchy")
+RouterType GetRouterTypeFromName(const std::string& router_name);
+
+// Get route graph model from its name in routing_settings ("complete" or "compact")
+RouteGraphModel GetRouteGraphModelFromName(const std::string& model_name);
+
+// Set routing_settings into catalogue
+void FillRoutingSettings(TransportCatalogue& catalogue, const Dict& route_settings);
+
+// Read make_base document from input in one pass and fill catalogue, base_requests aren't kept in memory.
+// Returns document with all other top-level values (render_settings, routing_settings, serialization_settings)
+Document StreamTransportCatalogue(TransportCatalogue& catalogue, std::istream& input);
+
+// Get route cache size in bytes from optional route_cache_settings of process_requests, 0 means no cache
+template <typename JsonDocument>
+size_t GetRouteCacheSize(const JsonDocument& document);
 
 /* ///// **** END FILL DATA INTO CATALOGUE ****///// */
 
 
 /* ///// **** READ REQUESTS FROM JSON AND FORM ANSWER ****///// */
 
-Node ParseStopAnswer(TransportCatalogue& catalogue, const Dict& request);
+// Functions below are instantiated for requests from Document (Request is Dict)
+// and from ArenaDocument (Request is ArenaDict).
+// Answers are written by json::Writer as they are formed, no Node is built for them
+
+template <typename Request>
+void ParseStopAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Request& request);
+
+template <typename Request>
+void ParseBusAnswer(json::Writer& answer, const TransportCatalogue& catalogue, const Request& request);
+
+template <typename Request>
+void ParseSvgBusRoute(json::Writer& answer, const TransportCatalogue& catalogue, const Request& request, const RenderSettings& render_settings);
+
+// Render settings and router for answers. They are got on the first request which needs them,
+// so base may decode them on demand. Getters are called by several threads at once
+class RequestData {
+public:
+    virtual const RenderSettings& GetRenderSettings() const = 0;
+    virtual const SingleBusRoute& GetRouter() const = 0;
+
+protected:
+    ~RequestData() = default;
+};
+
+// Write answer for a single request of stat_requests, false and nothing is written for unknown request type
+template <typename Request>
+bool ParseRequestAnswer(json::Writer& answer, TransportCatalogue& catalogue, const Request& request, const RequestData& data);
 
-Node ParseBusAnswer(const TransportCatalogue& catalogue, const Dict& request);
+// Get optional thread_count from execution_settings of process_requests, all cores are used by default
+template <typename JsonDocument>
+size_t GetThreadCount(const JsonDocument& document);
 
-Node ParseSvgBusRoute(const TransportCatalogue& catalogue, const Dict& request, const RenderSettings& render_settings);
+// Number of answers kept in memory by every thread of PrintRequestAnswers
+inline const size_t ANSWERS_PER_THREAD_IN_BLOCK = 256;
 
-Node GetReaquestAnwer(TransportCatalogue& catalogue, const Document& document, const RenderSettings& render_settings);
+// Write answers of all stat_requests into out as JSON array in order of requests,
+// requests are processed by thread_count threads. Text is the same as json::Print of the array of answers
+template <typename JsonDocument>
+void PrintRequestAnswers(std::ostream& out, TransportCatalogue& catalogue, const JsonDocument& document, const RequestData& data, size_t thread_count = 1);
 
-Node ParseRouteAnswer(const TransportCatalogue& catalogue, const Dict& request);
+template <typename Request>
+void ParseRouteAnswer(json::Writer& answer, const SingleBusRoute& tracker, const Request& request);
 
 /* ///// **** END FORM ANSWER ****///// */
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "json_writer.h"
+
+#include <stdexcept>
+
+namespace json {
+
+using namespace std::literals;
+
+// Separator before array item, check that value is expected here
+void Writer::BeforeValue() {
+    if (is_ready_) {
+        throw std::logic_error("Call Value() after ready object");
+    }
+    if (containers_.empty()) {
+        return;
+    }
+    auto& container = containers_.back();
+    if (container.is_dict) {
+        if (key_used_) {
+            throw std::logic_error("Invalid use of Value()");
+        }
+        key_used_ = true;
+    } else {
+        if (!container.is_empty) {
+            out_ << ", "sv;
+        }
+        container.is_empty = false;
+    }
+}
+
+
+// Every member of Dict ends with line break as in Print
+void Writer::AfterValue() {
+    if (containers_.empty()) {
+        is_ready_ = true;
+    } else if (containers_.back().is_dict) {
+        out_ << '\n';
+    }
+}
+
+
+Writer& Writer::Key(std::string_view key) {
+    if (containers_.empty() || !containers_.back().is_dict) {
+        throw std::logic_error("Call Key() outside of Dict");
+    }
+    if (!key_used_) {
+        throw std::logic_error("Call Key() after Key()");
+    }
+    auto& container = containers_.back();
+    if (!container.is_empty) {
+        out_ << ", "sv;
+    }
+    container.is_empty = false;
+    key_used_ = false;
+    out_ << '"' << key << "\":"sv;
+    return *this;
+}
+
+
+Writer& Writer::Value(std::nullptr_t) {
+    BeforeValue();
+    PrintValue(nullptr, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::Value(bool value) {
+    BeforeValue();
+    PrintValue(value, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::Value(int value) {
+    BeforeValue();
+    PrintValue(value, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::Value(double value) {
+    BeforeValue();
+    PrintValue(value, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::Value(std::string_view value) {
+    BeforeValue();
+    PrintValue(value, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::Value(const Node& node) {
+    BeforeValue();
+    PrintNode(node, out_);
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::RawValue(std::string_view text) {
+    BeforeValue();
+    out_ << text;
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::StartDict() {
+    BeforeValue();
+    out_ << "\n{   "sv;
+    containers_.push_back({true});
+    return *this;
+}
+
+
+Writer& Writer::EndDict() {
+    if (containers_.empty() || !containers_.back().is_dict || !key_used_) {
+        throw std::logic_error("Invalid use of EndDict()");
+    }
+    containers_.pop_back();
+    out_ << "}\n"sv;
+    AfterValue();
+    return *this;
+}
+
+
+Writer& Writer::StartArray() {
+    BeforeValue();
+    out_ << '[';
+    containers_.push_back({false});
+    return *this;
+}
+
+
+Writer& Writer::EndArray() {
+    if (containers_.empty() || containers_.back().is_dict) {
+        throw std::logic_error("Invalid use of EndArray()");
+    }
+    containers_.pop_back();
+    out_ << ']';
+    AfterValue();
+    return *this;
+}
+
+}  // namespace json
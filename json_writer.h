@@ -0,0 +1,61 @@
+#pragma once
+
+#include "json.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+// Writes JSON straight into output stream with the same calls as Builder, no Node is created.
+// Text is the same as json::Print of the built Node, if keys of every Dict are written in sorted order.
+// Wrong order of calls throws std::logic_error like Builder does
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : out_(out) {}
+
+    Writer& Key(std::string_view key);
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    Writer& Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+    Writer& Value(const std::string& value) {
+        return Value(std::string_view(value));
+    }
+    // Whole node, which is already built
+    Writer& Value(const Node& node);
+    // Value which is already written as JSON text by other Writer
+    Writer& RawValue(std::string_view text);
+
+    Writer& StartDict();
+    Writer& EndDict();
+    Writer& StartArray();
+    Writer& EndArray();
+
+    // One whole value is written
+    bool IsReady() const {
+        return is_ready_;
+    }
+
+private:
+    struct Container {
+        bool is_dict = false;
+        bool is_empty = true;
+    };
+
+    void BeforeValue();
+    void AfterValue();
+
+    std::ostream& out_;
+    std::vector<Container> containers_;
+    bool key_used_ = true;
+    bool is_ready_ = false;
+};
+
+}  // namespace json
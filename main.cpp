@@ -2,17 +2,18 @@
 #include <iostream>
 #include <string_view>
 #include "request_handler.h"
+#include "server.h"
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|patch_base|process_requests|serve [socket_path]]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
     
   
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
@@ -20,14 +21,28 @@ int main(int argc, char* argv[]) {
 
     const std::string_view mode(argv[1]);
 
+    // Only serve mode has an argument
+    if (argc > (mode == "serve"sv ? 3 : 2)) {
+        PrintUsage();
+        return 1;
+    }
+
     if (mode == "make_base"sv) {
         // make base here
         serialization_catalogue::MakeBase();
 
+    } else if (mode == "patch_base"sv) {
+        // apply delta to existing base
+        serialization_catalogue::PatchBase();
+
     } else if (mode == "process_requests"sv) {
         // process requests here
         serialization_catalogue::ProcessRequests();
 
+    } else if (mode == "serve"sv) {
+        // answer request documents line by line from stdin or socket
+        serialization_catalogue::Serve(argc == 3 ? argv[2] : "");
+
     } else {
         PrintUsage();
         return 1;
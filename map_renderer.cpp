@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <optional>
 #include <vector>
 #include <sstream>
@@ -152,11 +153,11 @@ void PointDraw::Draw(svg::ObjectContainer& container) const {
 // Return underlayer for bus name - USING IN DrawBusessRoutes FUNCTION
 svg::Text BusNameUnderlayer(const std::string_view bus_name, 
     const TransportCatalogue& catalogue, const SphereProjector& projector, 
-    const std::vector<std::string_view>& stops, const RenderSettings& render_settings) {
+    const std::vector<StopId>& stops, const RenderSettings& render_settings) {
 
     svg::Text bus_name_underlayer;
     
-    bus_name_underlayer.SetPosition(projector(catalogue.FindStop(stops.at(0)).coordinates));
+    bus_name_underlayer.SetPosition(projector(catalogue.GetStop(stops.at(0)).coordinates));
     bus_name_underlayer.SetOffset(render_settings.bus_label_offset);
     bus_name_underlayer.SetFontSize(render_settings.bus_label_font_size);
     bus_name_underlayer.SetFontFamily("Verdana");
@@ -175,11 +176,11 @@ svg::Text BusNameUnderlayer(const std::string_view bus_name,
 // Return bus name for drawing - USING IN DrawBusessRoutes FUNCTION
 svg::Text BusName(const std::string_view bus_name,
     const TransportCatalogue& catalogue, const SphereProjector& projector,
-    const std::vector<std::string_view>& stops, const RenderSettings& render_settings, const int index) {
+    const std::vector<StopId>& stops, const RenderSettings& render_settings, const int index) {
     
     svg::Text name_bus;
     
-    name_bus.SetPosition(projector(catalogue.FindStop(stops.at(0)).coordinates));
+    name_bus.SetPosition(projector(catalogue.GetStop(stops.at(0)).coordinates));
     name_bus.SetOffset(render_settings.bus_label_offset);
     name_bus.SetFontSize(render_settings.bus_label_font_size);
     name_bus.SetFontFamily("Verdana");
@@ -192,7 +193,7 @@ svg::Text BusName(const std::string_view bus_name,
 
 
 // Return route line for drawing - USING IN DrawBusessRoutes FUNCTION
-svg::Polyline DrawRouteLine(const std::vector<std::string_view>& stops, 
+svg::Polyline DrawRouteLine(const std::vector<StopId>& stops, 
     const SphereProjector& projector, const TransportCatalogue& catalogue, 
     const RenderSettings& render_settings, const int index) {
 
@@ -200,7 +201,7 @@ svg::Polyline DrawRouteLine(const std::vector<std::string_view>& stops,
     
     // Add ponts for bus route draw
     for (const auto& stop : stops) {
-        const auto Point = projector(catalogue.FindStop(stop).coordinates);
+        const auto Point = projector(catalogue.GetStop(stop).coordinates);
         route_line.AddPoint(Point);
     }
 
@@ -270,12 +271,12 @@ svg::Text DrawStopName(const Stop& stop, const SphereProjector& projector,
 // Function that forms all Drawable figures for route picture
 std::vector<unique_ptr<svg::Drawable>> DrawBusessRoutes(const RenderSettings& render_settings, const TransportCatalogue& catalogue) {
     
-    // Fill set for store buses in sort-condition
+    // Fill map for store buses in sort-condition
     const auto& all_buses = catalogue.GetAllBuses();
-    std::set<std::string_view> buses;
+    std::map<std::string_view, const Bus*> buses;
     for (const auto& bus : all_buses) {
         if (!bus.bus_route.empty()) {
-            buses.insert(bus.bus_number);
+            buses.emplace(bus.bus_number, &bus);
         }
     }
     
@@ -283,13 +284,14 @@ std::vector<unique_ptr<svg::Drawable>> DrawBusessRoutes(const RenderSettings& re
     vector<Coordinates> alls_stops;
     alls_stops.reserve(stops.size());
     // List for drawing stops points and stops names
-    std::set<std::string_view> stops_names;
+    std::map<std::string_view, const Stop*> stops_names;
     
     // Find all stops where at least one bus stops
-    for (const auto& bus : buses) {
-        for (const auto& stop : catalogue.FindBus(std::string(bus))) {
-            alls_stops.push_back(catalogue.FindStop(stop).coordinates);
-            stops_names.insert(stop);
+    for (const auto& [bus_name, bus] : buses) {
+        for (const StopId stop_id : bus->bus_route) {
+            const Stop& stop = catalogue.GetStop(stop_id);
+            alls_stops.push_back(stop.coordinates);
+            stops_names.emplace(stop.stop_name, &stop);
         }
     }
 
@@ -302,8 +304,8 @@ std::vector<unique_ptr<svg::Drawable>> DrawBusessRoutes(const RenderSettings& re
     std::vector<unique_ptr<svg::Drawable>> buses_names;
     
     int index = 0;
-    for (const auto& bus : buses) {
-        const auto& stops = catalogue.FindBus(std::string(bus));
+    for (const auto& [bus, bus_ptr] : buses) {
+        const auto& stops = bus_ptr->bus_route;
         
         // Route line for draw
         svg::Polyline route_line = DrawRouteLine(stops, projector, catalogue, render_settings, index);
@@ -318,13 +320,13 @@ std::vector<unique_ptr<svg::Drawable>> DrawBusessRoutes(const RenderSettings& re
         buses_names.push_back(std::make_unique<TextDraw>(TextDraw(bus_name)));
         
         // If bus_route isn't roundtrip - draw last stop of direct route
-        if (!catalogue.FindBusPtr(bus)->is_roundtrip && stops.at(stops.size() / 2) != stops.at(0)) {
+        if (!bus_ptr->is_roundtrip && stops.at(stops.size() / 2) != stops.at(0)) {
             svg::Text bus_name_underlayer = BusNameUnderlayer(bus, catalogue, projector, stops, render_settings);
-            bus_name_underlayer.SetPosition(projector(catalogue.FindStop(stops.at(stops.size() / 2)).coordinates));
+            bus_name_underlayer.SetPosition(projector(catalogue.GetStop(stops.at(stops.size() / 2)).coordinates));
             buses_names.push_back(std::make_unique<TextDraw>(TextDraw(bus_name_underlayer)));
 
             svg::Text bus_name = BusName(bus, catalogue, projector, stops, render_settings, index);
-            bus_name.SetPosition(projector(catalogue.FindStop(stops.at(stops.size() / 2)).coordinates));
+            bus_name.SetPosition(projector(catalogue.GetStop(stops.at(stops.size() / 2)).coordinates));
             buses_names.push_back(std::make_unique<TextDraw>(TextDraw(bus_name)));
         }
         
@@ -341,9 +343,9 @@ std::vector<unique_ptr<svg::Drawable>> DrawBusessRoutes(const RenderSettings& re
     std::vector<unique_ptr<svg::Drawable>> names_of_stops;
     
     //  Stops points and stops names for draw
-    for (const auto& stop_name : stops_names) {
+    for (const auto& [stop_name, stop_ptr] : stops_names) {
         
-        const auto& stop = catalogue.FindStop(stop_name);
+        const auto& stop = *stop_ptr;
 
         // Stops points
         svg::Circle circle = DrawStopPoint(stop, projector, render_settings);
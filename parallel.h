@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Number of threads used when it is not given explicitly
+inline size_t DefaultThreadCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Call func(index) for every index in [0, count) using up to thread_count threads.
+// Indexes are taken one by one, so tasks of different cost are balanced between threads.
+// The first exception thrown by func is rethrown in the calling thread.
+template <typename Func>
+void ForEachIndex(size_t count, Func func, size_t thread_count = DefaultThreadCount()) {
+    thread_count = std::min(thread_count, count);
+    if (thread_count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            func(index);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_index = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    const auto worker = [&]() {
+        for (size_t index = next_index++; index < count; index = next_index++) {
+            try {
+                func(index);
+            } catch (...) {
+                std::lock_guard guard(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_index = count;
+            }
+        }
+    };
+
+    // Calling thread is one of workers
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace parallel
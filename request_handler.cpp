@@ -2,46 +2,165 @@
 
 namespace serialization_catalogue {
 
+// Print route cache counters in one line
+void PrintRouteCacheStats(const graph::RouteCacheStats& stats, std::ostream& out) {
+	out << "route_cache hits="s << stats.hits << " misses="s << stats.misses << " evictions="s << stats.evictions
+		<< " trees="s << stats.tree_count << " bytes="s << stats.used_bytes << '/' << stats.max_bytes << '\n';
+}
 
-	
 
 /* ********************************* DATABASE PROCESSING ********************************* */
 
+namespace {
+
+// Write base in format selected by serialization_settings, default_format is used if it isn't given.
+// "compatible_layout" keeps stop names in protobuf base for older readers.
+// Old file is replaced only when the base is written completely
+void WriteBase(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const SingleBusRoute& router,
+	const Dict& serialization_settings, const std::string& file_name, const std::string& default_format) {
+	const auto format = serialization_settings.count("format"s) > 0 ? serialization_settings.at("format"s).AsString() : default_format;
+	if (format != "protobuf"s && format != "flat"s) {
+		throw std::invalid_argument("Unknown base format "s + format);
+	}
+	const bool compatible_layout = serialization_settings.count("compatible_layout"s) > 0 && serialization_settings.at("compatible_layout"s).AsBool();
+	if (compatible_layout && format != "protobuf"s) {
+		throw std::invalid_argument("Compatible layout is only for protobuf base"s);
+	}
+
+	//Serialize catalogue into file_name
+	if (format == "flat"s) {
+		WriteFlatBase(catalogue, render_settings, router, file_name);
+	} else {
+		SerializeTransportCatalogue(catalogue, render_settings, router, file_name, compatible_layout);
+	}
+}
+
+} // namespace
+
 // Read data from json into TransportCatalogue and serialize it
 void MakeBase(std::istream& input) {
 	TransportCatalogue catalogue;
-	auto input_data_document_ = json::Load(input);
+	// base_requests go into catalogue while they are parsed, document keeps only settings
+	const auto input_data_document_ = StreamTransportCatalogue(catalogue, input);
 
-	FillTransportCatalogue(catalogue, input_data_document_);
     const RenderSettings render_settings = SaveRenderSettings(input_data_document_);
 
 	// Get file_name for serialization
-	const auto file_name = input_data_document_.GetRoot().AsMap().at("serialization_settings"s).AsMap().at("file").AsString();
+	const auto& serialization_settings = input_data_document_.GetRoot().AsMap().at("serialization_settings"s).AsMap();
+	const auto file_name = serialization_settings.at("file").AsString();
 
-	//Serialize catalogue into file_name
-	SerializeTransportCatalogue(catalogue, render_settings, file_name);
+	// Build route graph and router once, they are stored in base with catalogue
+	const SingleBusRoute router(catalogue);
+
+	// Base is written in protobuf format unless flat one is selected
+	WriteBase(catalogue, render_settings, router, serialization_settings, file_name, "protobuf"s);
+}
+
+// Read base from file of serialization_settings, apply delta and write base into patched_file or back into file
+void PatchBase(std::istream& input) {
+	const auto delta_document = json::Load(input);
+	const auto& delta = delta_document.GetRoot().AsMap();
+
+	const auto& serialization_settings = delta.at("serialization_settings"s).AsMap();
+	const auto file_name = serialization_settings.at("file"s).AsString();
+	const auto patched_file_name = serialization_settings.count("patched_file"s) > 0 ? serialization_settings.at("patched_file"s).AsString() : file_name;
+	const auto base_format = IsFlatBase(file_name) ? "flat"s : "protobuf"s;
+
+	// Patched base goes into temporary file renamed over file, so mapped flat base of file stays valid
+	// and a broken patch leaves file as it was
+	const LoadedBase base(file_name, 0);
+	TransportCatalogue catalogue;
+	const auto unchanged = PatchCatalogue(base.catalogue, delta, catalogue);
+
+	const RenderSettings render_settings = delta.count("render_settings"s) > 0 ? SaveRenderSettings(delta_document) : base.GetRenderSettings();
+
+	// Unchanged buses have the same statistics
+	for (BusId bus = 0; bus < unchanged.old_buses.size(); ++bus) {
+		if (const auto old_bus = unchanged.old_buses[bus]) {
+			catalogue.SetBusStats(bus, base.catalogue.GetBusStats(*old_bus));
+		}
+	}
+
+	const SingleBusRoute router(catalogue, base.GetRouter(), unchanged);
+
+	// Base keeps its format unless other one is selected
+	WriteBase(catalogue, render_settings, router, serialization_settings, patched_file_name, base_format);
+}
+
+// Flat base is mapped at once, protobuf base leaves render settings and router for the first request
+LoadedBase::LoadedBase(const std::string& file_name, size_t route_cache_size)
+	: route_cache_size_(route_cache_size) {
+	// Deserialize catalogue from file_name, format of base is found by its header
+	if (IsFlatBase(file_name)) {
+		RenderSettings render_settings;
+		std::unique_ptr<SingleBusRoute> router;
+		ReadFlatBase(file_name, catalogue, render_settings, router);
+		parts_ = MakeLazyBaseParts(std::move(render_settings), std::move(router));
+	} else {
+		parts_ = DeserializeTransportCatalogueLazily(file_name, catalogue);
+	}
+}
+
+
+const RenderSettings& LoadedBase::GetRenderSettings() const {
+	std::call_once(render_settings_flag_, [this] {
+		render_settings_ = parts_.render_settings();
+		// Loader keeps the file text
+		parts_.render_settings = nullptr;
+	});
+	return render_settings_;
+}
+
+
+const SingleBusRoute& LoadedBase::GetRouter() const {
+	std::call_once(router_flag_, [this] {
+		router_ = parts_.router();
+		parts_.router = nullptr;
+
+		// Base made by older version has no router inside
+		if (!router_) {
+			router_ = std::make_unique<SingleBusRoute>(catalogue);
+		}
+
+		if (route_cache_size_ > 0) {
+			router_->EnableRouteCache(route_cache_size_);
+		}
+		router_ready_.store(true, std::memory_order_release);
+	});
+	return *router_;
+}
+
+
+std::optional<graph::RouteCacheStats> LoadedBase::GetRouteCacheStats() const {
+	if (!router_ready_.load(std::memory_order_acquire)) {
+		return std::nullopt;
+	}
+	return router_->GetRouteCacheStats();
+}
+
+
+// Deserialize base from file_name, router is built if the base has none
+std::unique_ptr<LoadedBase> LoadBase(const std::string& file_name, size_t route_cache_size) {
+	return std::make_unique<LoadedBase>(file_name, route_cache_size);
 }
 
 // Deserialize data and process requests
 void ProcessRequests(std::ostream& out, std::istream& input) {
-	const auto input_data_document_ = json::Load(input);
+	// Requests are read only, they are kept in one arena
+	const json::ArenaDocument input_data_document_(input);
 
 	// Get file_name for serialization
-	const auto file_name = input_data_document_.GetRoot().AsMap().at("serialization_settings"s).AsMap().at("file").AsString();
+	const std::string file_name(input_data_document_.GetRoot().AsMap().at("serialization_settings"s).AsMap().at("file"s).AsString());
 
-	TransportCatalogue catalogue;
-    RenderSettings render_settings;
-    
-	// Deserialize catalogue from file_name
-	DeserializeTransportCatalogue(file_name, catalogue, render_settings);
-	
-	
-
-	// Get answers
-	json::Document output_data_document_(GetReaquestAnwer(catalogue, input_data_document_, render_settings));
-
-	// Print answers into out
-	json::Print(output_data_document_, out);
+	const auto base = LoadBase(file_name, GetRouteCacheSize(input_data_document_));
+
+	// Answers are printed into out as they are formed
+	PrintRequestAnswers(out, base->catalogue, input_data_document_, *base, GetThreadCount(input_data_document_));
+
+	// Cache counters go to log, out has only answers
+	if (const auto stats = base->GetRouteCacheStats()) {
+		PrintRouteCacheStats(*stats);
+	}
 }
 
 
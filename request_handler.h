@@ -4,9 +4,15 @@
 #include "json_reader.h"
 #include "transport_catalogue.h"
 
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <transport_catalogue.pb.h>
+#include "base_patch.h"
+#include "flat_base.h"
 #include "map_renderer.h"
 #include "serialization.h"
 
@@ -16,9 +22,48 @@ namespace serialization_catalogue {
     
 /* ********************************* DATABASE PROCESSING ********************************* */
 
+// Deserialized base: everything needed to answer stat_requests.
+// Catalogue is decoded at once, render settings and router are decoded on the first request which needs them.
+// Router keeps a reference to catalogue, so the base is never moved
+class LoadedBase final : public RequestData {
+public:
+	// Router is built if the base has none. Route cache is enabled if route_cache_size isn't 0
+	LoadedBase(const std::string& file_name, size_t route_cache_size);
+
+	const RenderSettings& GetRenderSettings() const override;
+	const SingleBusRoute& GetRouter() const override;
+
+	// Counters of route cache, nothing if router isn't loaded yet or cache is disabled
+	std::optional<graph::RouteCacheStats> GetRouteCacheStats() const;
+
+	TransportCatalogue catalogue;
+
+private:
+	size_t route_cache_size_ = 0;
+	mutable LazyBaseParts parts_;
+
+	mutable std::once_flag render_settings_flag_;
+	mutable RenderSettings render_settings_;
+
+	mutable std::once_flag router_flag_;
+	mutable std::unique_ptr<SingleBusRoute> router_;
+	mutable std::atomic<bool> router_ready_ = false;
+};
+
 // Read data from json into TransportCatalogue and serialize it
 void MakeBase(std::istream& input = std::cin);
 
+// Apply delta document to base and write patched base. Stored statistics and route graph edges of buses
+// which delta doesn't touch are copied, routing engine is built anew. Base file is replaced only by complete patched base
+void PatchBase(std::istream& input = std::cin);
+
+// Print route cache counters in one line
+void PrintRouteCacheStats(const graph::RouteCacheStats& stats, std::ostream& out = std::cerr);
+
+// Deserialize base from file_name, router is built if the base has none.
+// Route cache is enabled if route_cache_size isn't 0
+std::unique_ptr<LoadedBase> LoadBase(const std::string& file_name, size_t route_cache_size = 0);
+
 // Deserialize data and process requests
 void ProcessRequests(std::ostream& out = std::cout, std::istream& input = std::cin);
 
@@ -0,0 +1,179 @@
+#include "road_distances.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace transport {
+
+namespace detail {
+
+using namespace std;
+
+void RoadDistances::Add(StopId from, StopId to, int distance) {
+    added_.push_back({from, to, distance});
+    frozen_.store(false, memory_order_relaxed);
+}
+
+
+void RoadDistances::SetLoader(Loader loader) {
+    loader_ = move(loader);
+    frozen_.store(false, memory_order_relaxed);
+}
+
+
+optional<int> RoadDistances::Find(StopId from, StopId to) const {
+    if (const auto arc = FindArc(from, to)) {
+        return distances_[*arc];
+    }
+    return nullopt;
+}
+
+
+optional<int> RoadDistances::FindMeasured(StopId from, StopId to) const {
+    if (const auto arc = FindArc(from, to); arc && measured_[*arc]) {
+        return distances_[*arc];
+    }
+    return nullopt;
+}
+
+
+const vector<uint32_t>& RoadDistances::GetOffsets() const {
+    Freeze();
+    return offsets_;
+}
+
+
+const vector<StopId>& RoadDistances::GetTargets() const {
+    Freeze();
+    return targets_;
+}
+
+
+const vector<int>& RoadDistances::GetDistances() const {
+    Freeze();
+    return distances_;
+}
+
+
+const vector<bool>& RoadDistances::GetMeasured() const {
+    Freeze();
+    return measured_;
+}
+
+
+void RoadDistances::Assign(vector<uint32_t> offsets, vector<StopId> targets, vector<int> distances, vector<bool> measured) {
+    if (targets.size() != distances.size() || targets.size() != measured.size()
+        || (offsets.empty() ? !targets.empty() : offsets.front() != 0 || offsets.back() != targets.size())
+        || !is_sorted(offsets.begin(), offsets.end())) {
+        throw invalid_argument("Broken road distances table");
+    }
+    lock_guard guard(freeze_mutex_);
+    added_.clear();
+    loader_ = nullptr;
+    offsets_ = move(offsets);
+    targets_ = move(targets);
+    distances_ = move(distances);
+    measured_ = move(measured);
+    frozen_.store(true, memory_order_release);
+}
+
+
+optional<size_t> RoadDistances::FindArc(StopId from, StopId to) const {
+    Freeze();
+    if (from + 1 >= offsets_.size()) {
+        return nullopt;
+    }
+    const auto begin = targets_.begin() + offsets_[from];
+    const auto end = targets_.begin() + offsets_[from + 1];
+    const auto it = lower_bound(begin, end, to);
+    if (it == end || *it != to) {
+        return nullopt;
+    }
+    return static_cast<size_t>(it - targets_.begin());
+}
+
+
+// Merge added distances with frozen ones and rebuild the table
+void RoadDistances::Freeze() const {
+    if (frozen_.load(memory_order_acquire)) {
+        return;
+    }
+    lock_guard guard(freeze_mutex_);
+    if (frozen_.load(memory_order_relaxed)) {
+        return;
+    }
+
+    // Measured distances, frozen ones go first so that later added replace them
+    vector<RoadDistance> measured;
+    measured.reserve(targets_.size() + added_.size());
+    ForEachFrozen([&measured](const RoadDistance& road) {
+        measured.push_back(road);
+    });
+    if (loader_) {
+        const auto loaded = loader_();
+        loader_ = nullptr;
+        measured.insert(measured.end(), loaded.begin(), loaded.end());
+    }
+    measured.insert(measured.end(), added_.begin(), added_.end());
+    added_.clear();
+
+    const auto by_stops = [](const RoadDistance& lhs, const RoadDistance& rhs) {
+        return lhs.from != rhs.from ? lhs.from < rhs.from : lhs.to < rhs.to;
+    };
+    const auto same_stops = [](const RoadDistance& lhs, const RoadDistance& rhs) {
+        return lhs.from == rhs.from && lhs.to == rhs.to;
+    };
+    stable_sort(measured.begin(), measured.end(), by_stops);
+    // The last added distance of the same stops is kept
+    vector<RoadDistance> unique_measured;
+    unique_measured.reserve(measured.size());
+    for (size_t i = 0; i < measured.size(); ++i) {
+        if (i + 1 < measured.size() && same_stops(measured[i], measured[i + 1])) {
+            continue;
+        }
+        unique_measured.push_back(measured[i]);
+    }
+
+    // Back direction is added where it isn't measured
+    vector<pair<RoadDistance, bool>> arcs;
+    arcs.reserve(unique_measured.size() * 2);
+    for (const auto& road : unique_measured) {
+        arcs.push_back({road, true});
+        const RoadDistance back{road.to, road.from, road.distance};
+        if (!binary_search(unique_measured.begin(), unique_measured.end(), back, by_stops)) {
+            arcs.push_back({back, false});
+        }
+    }
+    sort(arcs.begin(), arcs.end(), [&by_stops](const auto& lhs, const auto& rhs) {
+        return by_stops(lhs.first, rhs.first);
+    });
+
+    StopId stop_count = 0;
+    for (const auto& [road, is_measured] : arcs) {
+        stop_count = max(stop_count, max(road.from, road.to) + 1);
+    }
+
+    offsets_.assign(stop_count + 1, 0);
+    targets_.clear();
+    distances_.clear();
+    measured_.clear();
+    targets_.reserve(arcs.size());
+    distances_.reserve(arcs.size());
+    measured_.reserve(arcs.size());
+    for (const auto& [road, is_measured] : arcs) {
+        ++offsets_[road.from + 1];
+        targets_.push_back(road.to);
+        distances_.push_back(road.distance);
+        measured_.push_back(is_measured);
+    }
+    for (StopId stop = 0; stop < stop_count; ++stop) {
+        offsets_[stop + 1] += offsets_[stop];
+    }
+
+    frozen_.store(true, memory_order_release);
+}
+
+} // End namespace detail
+
+} // End namespace transport
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace transport {
+
+namespace detail {
+
+using StopId = std::uint32_t;
+
+// Road distance measured from one stop to another
+struct RoadDistance {
+    StopId from = 0;
+    StopId to = 0;
+    int distance = 0;
+};
+
+// Road distances between stops by their ids.
+// Added distances are collected in a list, the first lookup freezes them into compressed sparse row layout:
+// neighbours of every stop lie in one sorted block, so a lookup is a short search in contiguous memory.
+// Distance of back direction is put into the table too, so fallback to it costs nothing.
+// Lookups may run concurrently, adding a distance isn't thread-safe
+class RoadDistances {
+public:
+    RoadDistances() = default;
+
+    // Distance is replaced if it was already added for the same stops
+    void Add(StopId from, StopId to, int distance);
+
+    // Distances are got from loader on the first lookup, e.g. when they are decoded from base on demand.
+    // They go before distances added by Add()
+    using Loader = std::function<std::vector<RoadDistance>()>;
+    void SetLoader(Loader loader);
+
+    // Measured distance from one stop to another or distance back if there is no direct one
+    std::optional<int> Find(StopId from, StopId to) const;
+
+    // Only measured distance from one stop to another
+    std::optional<int> FindMeasured(StopId from, StopId to) const;
+
+    // Call func(RoadDistance) for every measured distance in order of from, then to
+    template <typename Func>
+    void ForEach(Func func) const;
+
+    // Frozen table as is, it's stored in base and assigned back without sorting.
+    // Arcs of stop s are positions [offsets[s], offsets[s + 1]) of targets, distances and measured flags
+    const std::vector<std::uint32_t>& GetOffsets() const;
+    const std::vector<StopId>& GetTargets() const;
+    const std::vector<int>& GetDistances() const;
+    const std::vector<bool>& GetMeasured() const;
+
+    // Replace all distances with table got from the getters, throws std::invalid_argument if arrays don't match
+    void Assign(std::vector<std::uint32_t> offsets, std::vector<StopId> targets, std::vector<int> distances, std::vector<bool> measured);
+
+private:
+    void Freeze() const;
+    template <typename Func>
+    void ForEachFrozen(Func func) const;
+    // Position of to in block of from or nothing
+    std::optional<size_t> FindArc(StopId from, StopId to) const;
+
+    // Added since the last freeze
+    mutable std::vector<RoadDistance> added_;
+    mutable Loader loader_;
+
+    // Arcs of stop s are positions [offsets_[s], offsets_[s + 1])
+    mutable std::vector<std::uint32_t> offsets_;
+    mutable std::vector<StopId> targets_;
+    mutable std::vector<int> distances_;
+    // false for arc of back direction which is put for fallback
+    mutable std::vector<bool> measured_;
+
+    mutable std::atomic<bool> frozen_ = true;
+    mutable std::mutex freeze_mutex_;
+};
+
+template <typename Func>
+void RoadDistances::ForEach(Func func) const {
+    Freeze();
+    ForEachFrozen(func);
+}
+
+template <typename Func>
+void RoadDistances::ForEachFrozen(Func func) const {
+    for (StopId from = 0; from + 1 < offsets_.size(); ++from) {
+        for (size_t arc = offsets_[from]; arc < offsets_[from + 1]; ++arc) {
+            if (measured_[arc]) {
+                func(RoadDistance{from, targets_[arc], distances_[arc]});
+            }
+        }
+    }
+}
+
+} // End namespace detail
+
+} // End namespace transport
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace graph {
+
+// Counters of RouteCache, bytes are counted for stored trees only
+struct RouteCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t tree_count = 0;
+    size_t used_bytes = 0;
+    size_t max_bytes = 0;
+};
+
+// LRU cache of shortest path trees by origin vertex.
+// The first route from an origin computes the tree to all vertices, next routes from it
+// are a walk over predecessors. Total size of stored trees doesn't exceed max_bytes.
+// BuildRoute may be called concurrently, trees are computed outside of the lock.
+template <typename Weight>
+class RouteCache {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Tree = ShortestPathTree<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+
+    RouteCache(const Graph& graph, size_t max_bytes);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to);
+
+    RouteCacheStats GetStats() const;
+
+private:
+    // Most recently used tree is the first one
+    using Entries = std::list<std::shared_ptr<const Tree>>;
+
+    size_t GetTreeBytes() const {
+        return sizeof(Tree) + graph_.GetVertexCount() * (sizeof(Weight) + sizeof(EdgeId));
+    }
+
+    std::shared_ptr<const Tree> FindTree(VertexId from);
+    void StoreTree(std::shared_ptr<const Tree> tree);
+
+    CsrGraph<Weight> graph_;
+    const size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+    Entries entries_;
+    std::unordered_map<VertexId, typename Entries::iterator> entries_by_origin_;
+    size_t used_bytes_ = 0;
+    size_t evictions_ = 0;
+
+    std::atomic<size_t> hits_ = 0;
+    std::atomic<size_t> misses_ = 0;
+};
+
+template <typename Weight>
+RouteCache<Weight>::RouteCache(const Graph& graph, size_t max_bytes)
+    : graph_(graph)
+    , max_bytes_(max_bytes)
+{
+}
+
+template <typename Weight>
+std::optional<typename RouteCache<Weight>::RouteInfo> RouteCache<Weight>::BuildRoute(VertexId from, VertexId to) {
+    auto tree = FindTree(from);
+    if (tree) {
+        ++hits_;
+    } else {
+        ++misses_;
+        tree = std::make_shared<const Tree>(BuildShortestPathTree(graph_, from));
+        StoreTree(tree);
+    }
+    return tree->BuildRoute(graph_, to);
+}
+
+template <typename Weight>
+RouteCacheStats RouteCache<Weight>::GetStats() const {
+    std::lock_guard guard(mutex_);
+    return {hits_, misses_, evictions_, entries_.size(), used_bytes_, max_bytes_};
+}
+
+template <typename Weight>
+std::shared_ptr<const typename RouteCache<Weight>::Tree> RouteCache<Weight>::FindTree(VertexId from) {
+    std::lock_guard guard(mutex_);
+    const auto it = entries_by_origin_.find(from);
+    if (it == entries_by_origin_.end()) {
+        return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return entries_.front();
+}
+
+template <typename Weight>
+void RouteCache<Weight>::StoreTree(std::shared_ptr<const Tree> tree) {
+    const size_t tree_bytes = GetTreeBytes();
+    if (tree_bytes > max_bytes_) {
+        return;
+    }
+
+    std::lock_guard guard(mutex_);
+    // Other thread may have computed the same tree meanwhile
+    if (entries_by_origin_.count(tree->from) > 0) {
+        return;
+    }
+    while (used_bytes_ + tree_bytes > max_bytes_) {
+        entries_by_origin_.erase(entries_.back()->from);
+        entries_.pop_back();
+        used_bytes_ -= tree_bytes;
+        ++evictions_;
+    }
+    entries_.push_front(std::move(tree));
+    entries_by_origin_[entries_.front()->from] = entries_.begin();
+    used_bytes_ += tree_bytes;
+}
+
+}  // namespace graph
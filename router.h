@@ -1,11 +1,13 @@
 #pragma once
 
 #include "graph.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,104 +16,201 @@
 
 namespace graph {
 
+// Common interface of all shortest path engines, so the engine can be chosen at runtime
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
+class RoutingEngine {
 public:
-    explicit Router(const Graph& graph);
-
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    virtual ~RoutingEngine() = default;
 
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+};
+
+// All-pairs engine: Floyd-Warshall precomputation in constructor, O(route length) queries.
+// Tables are flat vertex_count x vertex_count matrices, Floyd-Warshall is computed by tiles:
+// for every diagonal tile, first the tile itself, then its row and column, then all other tiles.
+// Tiles of the last two phases are independent and are processed in parallel.
+template <typename Weight>
+class Router final : public RoutingEngine<Weight> {
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using typename RoutingEngine<Weight>::RouteInfo;
+
+    static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Row-major matrices, weights is NO_ROUTE if there is no route,
+    // prev_edges is last edge of route or NO_EDGE for empty route
+    struct RoutesInternalData {
+        size_t vertex_count = 0;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+    explicit Router(const Graph& graph, size_t thread_count = parallel::DefaultThreadCount());
+
+    // Use routes precomputed earlier for the same graph (e.g. loaded from file)
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const RoutesInternalData& GetRoutesInternalData() const {
+        return routes_internal_data_;
+    }
+
+private:
+    // Tile side, three tiles of weights and prev_edges fit in L2 cache
+    static constexpr size_t TILE_SIZE = 64;
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        routes_internal_data_.vertex_count = vertex_count;
+        routes_internal_data_.weights.assign(vertex_count * vertex_count, NO_ROUTE);
+        routes_internal_data_.prev_edges.assign(vertex_count * vertex_count, NO_EDGE);
+
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            routes_internal_data_.weights[vertex * vertex_count + vertex] = ZERO_WEIGHT;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t index = vertex * vertex_count + edge.to;
+                if (routes_internal_data_.weights[index] > edge.weight) {
+                    routes_internal_data_.weights[index] = edge.weight;
+                    routes_internal_data_.prev_edges[index] = edge_id;
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Sum of weights which is NO_ROUTE if any of them is NO_ROUTE
+    static Weight AddWeights(Weight lhs, Weight rhs) {
+        if constexpr (std::numeric_limits<Weight>::has_infinity) {
+            // max + x is not less than any weight, no check is needed
+            return lhs + rhs;
+        } else {
+            return rhs == NO_ROUTE ? NO_ROUTE : lhs + rhs;
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    // Relax routes of tile (tile_from, tile_to) through vertices of tile_through
+    void RelaxTile(size_t tile_from, size_t tile_to, size_t tile_through) {
+        const size_t vertex_count = routes_internal_data_.vertex_count;
+        Weight* const weights = routes_internal_data_.weights.data();
+        EdgeId* const prev_edges = routes_internal_data_.prev_edges.data();
+
+        const size_t from_end = std::min(vertex_count, (tile_from + 1) * TILE_SIZE);
+        const size_t to_begin = tile_to * TILE_SIZE;
+        const size_t to_end = std::min(vertex_count, to_begin + TILE_SIZE);
+        const size_t through_end = std::min(vertex_count, (tile_through + 1) * TILE_SIZE);
+
+        for (VertexId vertex_through = tile_through * TILE_SIZE; vertex_through < through_end; ++vertex_through) {
+            const Weight* const row_through = weights + vertex_through * vertex_count;
+            const EdgeId* const prev_row_through = prev_edges + vertex_through * vertex_count;
+            for (VertexId vertex_from = tile_from * TILE_SIZE; vertex_from < from_end; ++vertex_from) {
+                const Weight weight_from = weights[vertex_from * vertex_count + vertex_through];
+                if (weight_from == NO_ROUTE) {
+                    continue;
+                }
+                Weight* const row_from = weights + vertex_from * vertex_count;
+                EdgeId* const prev_row_from = prev_edges + vertex_from * vertex_count;
+                // Route through vertex_through is never better for vertex_to == vertex_through,
+                // so prev_row_through[vertex_to] is always a real edge here
+                for (VertexId vertex_to = to_begin; vertex_to < to_end; ++vertex_to) {
+                    const Weight candidate_weight = AddWeights(weight_from, row_through[vertex_to]);
+                    if (candidate_weight < row_from[vertex_to]) {
+                        row_from[vertex_to] = candidate_weight;
+                        prev_row_from[vertex_to] = prev_row_through[vertex_to];
                     }
                 }
             }
         }
     }
 
+    void ComputeRoutes(size_t thread_count) {
+        const size_t tile_count = (routes_internal_data_.vertex_count + TILE_SIZE - 1) / TILE_SIZE;
+        for (size_t tile_through = 0; tile_through < tile_count; ++tile_through) {
+            // Diagonal tile depends only on itself
+            RelaxTile(tile_through, tile_through, tile_through);
+
+            // Tiles of the same row and column depend only on themselves and the diagonal tile
+            parallel::ForEachIndex(2 * tile_count, [this, tile_count, tile_through](size_t index) {
+                const size_t tile = index % tile_count;
+                if (tile == tile_through) {
+                    return;
+                }
+                if (index < tile_count) {
+                    RelaxTile(tile_through, tile, tile_through);
+                } else {
+                    RelaxTile(tile, tile_through, tile_through);
+                }
+            }, thread_count);
+
+            // Other tiles depend only on themselves and tiles of the row and column
+            parallel::ForEachIndex(tile_count * tile_count, [this, tile_count, tile_through](size_t index) {
+                const size_t tile_from = index / tile_count;
+                const size_t tile_to = index % tile_count;
+                if (tile_from != tile_through && tile_to != tile_through) {
+                    RelaxTile(tile_from, tile_to, tile_through);
+                }
+            }, thread_count);
+        }
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
     InitializeRoutesInternalData(graph);
+    ComputeRoutes(thread_count);
+}
 
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
     const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    if (routes_internal_data_.vertex_count != vertex_count
+        || routes_internal_data_.weights.size() != vertex_count * vertex_count
+        || routes_internal_data_.prev_edges.size() != vertex_count * vertex_count) {
+        throw std::invalid_argument("Routes data doesn't match the graph");
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    const size_t vertex_count = routes_internal_data_.vertex_count;
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+    const Weight weight = routes_internal_data_.weights[from * vertex_count + to];
+    if (weight == NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (EdgeId edge_id = routes_internal_data_.prev_edges[from * vertex_count + to];
+         edge_id != NO_EDGE;
+         edge_id = routes_internal_data_.prev_edges[from * vertex_count + graph_.GetEdge(edge_id).from])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -1,5 +1,12 @@
 #include "serialization.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+
 
 namespace serialization_catalogue {
 
@@ -15,77 +22,175 @@ SerializedStop SerializeSingleStop(const SingleStop& input_stop) {
 	return serialized_stop;
 }
 
-// Serialize stops from input_catalogue to serialized_catalogue
-void SerializeStops(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue) {
+// Serialize stops from input_catalogue into sections of STOPS_IN_SECTION stops
+void SerializeStops(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections) {
+	size_t count = 0;
 	for (const SingleStop& input_stop : input_catalogue.GetAllStops()) {
-		*serialized_catalogue.add_stops() = std::move(SerializeSingleStop(input_stop));
+		if (count++ % STOPS_IN_SECTION == 0) {
+			sections.emplace_back();
+		}
+		*sections.back().add_stops() = std::move(SerializeSingleStop(input_stop));
 	}
 }
 
-
-// Create a SerializedBus from common Bus
-SerializedBus SerializeSingleBus(const SingleBus& input_bus) {
+// Create a SerializedBus from common Bus, stops are stored by indexes and by names in compatible layout
+SerializedBus SerializeSingleBus(const TransportCatalogue& input_catalogue, BusId bus, bool compatible_layout) {
+	const SingleBus& input_bus = input_catalogue.GetBus(bus);
 	SerializedBus serialized_bus;
 	serialized_bus.set_bus_number(input_bus.bus_number);
 	serialized_bus.set_roundtrip(input_bus.is_roundtrip);
-	for (const auto stop : input_bus.bus_route) {
-		*serialized_bus.add_stops_at_route() = std::move(std::string(stop));
+	serialized_bus.mutable_stop_indexes()->Add(input_bus.bus_route.begin(), input_bus.bus_route.end());
+	if (compatible_layout) {
+		for (const StopId stop : input_bus.bus_route) {
+			serialized_bus.add_stops_at_route(input_catalogue.GetAllStops()[stop].stop_name);
+		}
 	}
 	return serialized_bus;
 }
 
-// Serialize buses from input_catalogue to serialize_catalogue
-void SerializeBuses(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue) {
-	for (const SingleBus& single_bus : input_catalogue.GetAllBuses()) {
-		*serialized_catalogue.add_buses() = std::move(SerializeSingleBus(single_bus));
+// Serialize buses from input_catalogue into sections, section is closed when its routes have ROUTE_STOPS_IN_SECTION stops
+void SerializeBuses(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections, bool compatible_layout) {
+	const auto bus_count = static_cast<BusId>(input_catalogue.GetAllBuses().size());
+	size_t route_stops = ROUTE_STOPS_IN_SECTION;
+	for (BusId bus = 0; bus < bus_count; ++bus) {
+		if (route_stops >= ROUTE_STOPS_IN_SECTION) {
+			sections.emplace_back();
+			route_stops = 0;
+		}
+		route_stops += input_catalogue.GetBus(bus).bus_route.size() + 1;
+		*sections.back().add_buses() = std::move(SerializeSingleBus(input_catalogue, bus, compatible_layout));
 	}
 }
 
-
-// Create a SerializedDistance from data
-SerializedDistance SerializeSingleDistance(const std::pair<const Stop*, const Stop*> stops, int distance) {
-	SerializedDistance serialized_distance;
-	serialized_distance.set_from_stop(stops.first->stop_name);
-	serialized_distance.set_to_stop(stops.second->stop_name);
-	serialized_distance.set_distance(distance);
-	return serialized_distance;
-}
-
-// Serialize real measured distancies between stops from input_catalogue to serialize_catalogue
-void SerializeDistancies(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue) {
-	for (const auto [stops, distance] : input_catalogue.RealStopDistanceData()) {
-		*serialized_catalogue.add_distancies() = SerializeSingleDistance(stops, distance);
+// Serialize statistics of buses from input_catalogue into sections of BUS_STATS_IN_SECTION buses.
+// Bus requests take statistics from base, they are kept apart from buses to be decoded on the first Bus request
+void SerializeBusStats(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections) {
+	const auto bus_count = static_cast<BusId>(input_catalogue.GetAllBuses().size());
+	for (BusId bus = 0; bus < bus_count; ++bus) {
+		if (bus % BUS_STATS_IN_SECTION == 0) {
+			sections.emplace_back();
+		}
+		const auto& stats = input_catalogue.GetBusStats(bus);
+		auto& serialized_stats = *sections.back().add_bus_stats();
+		serialized_stats.set_stop_count(stats.stop_count);
+		serialized_stats.set_unique_stop_count(stats.unique_stop_count);
+		serialized_stats.set_route_length(stats.route_length);
+		serialized_stats.set_geo_length(stats.geo_length);
 	}
 }
 
+// Serialize real measured distancies between stops from input_catalogue into sections of DISTANCES_IN_SECTION distances.
+// Distances go in order of stops, so deltas of stop indexes are small numbers. Deltas go on through all sections.
+// Compatible layout has every distance with stop names as well
+void SerializeDistancies(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections, bool compatible_layout) {
+	const auto& stops = input_catalogue.GetAllStops();
+	size_t count = 0;
+	StopId prev_from = 0;
+	StopId prev_to = 0;
+	input_catalogue.RealStopDistanceData().ForEach([&](const transport::detail::RoadDistance& road) {
+		if (count++ % DISTANCES_IN_SECTION == 0) {
+			sections.emplace_back();
+		}
+		auto& table = *sections.back().mutable_distance_table();
+		table.add_from_deltas(road.from - prev_from);
+		table.add_to_deltas(road.from == prev_from ? road.to - prev_to : road.to);
+		table.add_distances(road.distance);
+		prev_from = road.from;
+		prev_to = road.to;
+
+		if (compatible_layout) {
+			auto& distance = *sections.back().add_distancies();
+			distance.set_from_stop(stops[road.from].stop_name);
+			distance.set_to_stop(stops[road.to].stop_name);
+			distance.set_distance(road.distance);
+		}
+	});
+}
 
-// Serialize TransportCatalogue Data into file
-void SerializeTransportCatalogue(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const std::string& file) {
-	std::ofstream out_file(file, std::ios::binary);
+// Serialize TransportCatalogue Data and precomputed router into file
+void SerializeTransportCatalogue(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const SingleBusRoute& router, const std::string& file,
+	bool compatible_layout) {
+	// Base is written into temporary file which replaces file at once, so readers never see a half-written base
+	const std::string temp_file = file + ".tmp";
+	std::ofstream out_file(temp_file, std::ios::binary);
 
 	if (!out_file.is_open()) {
 		throw std::logic_error("Can't open file");
 	}
 
-	SerializedTransportCatalogue serialized_cataloge;
+	std::vector<SerializedTransportCatalogue> sections(2);
+
+	// SERIALIZE routing_settings
+	SerializeRoutingSettings(catalogue, sections[0]);
+
+	// SERIALIZE RenderSettings
+	*sections[1].mutable_render_settings() = std::move(GetSerializedRenderSettings(render_settings));
 
 	// SERIALIZE ALL STOPS 
-	SerializeStops(catalogue, serialized_cataloge);
+	SerializeStops(catalogue, sections);
 
 	// SERIALIZE ALL BUSES
-	SerializeBuses(catalogue, serialized_cataloge);
+	SerializeBuses(catalogue, sections, compatible_layout);
+
+	// SERIALIZE statistics of buses
+	SerializeBusStats(catalogue, sections);
 
 	// SERIALIZE ALL DISTANCIES
-	SerializeDistancies(catalogue, serialized_cataloge);
-    
-    // SERIALIZE RenderSettings
-    *serialized_cataloge.mutable_render_settings() = std::move(GetSerializedRenderSettings(render_settings));
+	SerializeDistancies(catalogue, sections, compatible_layout);
 
-	// SERIALIZE routing_settings
-	SerializeRoutingSettings(catalogue, serialized_cataloge);
-        
-	//Serialize serialized_cataloge into outfile
-	serialized_cataloge.SerializeToOstream(&out_file);
+	// SERIALIZE route graph and router
+	SerializeRouter(catalogue, router, sections);
+
+	//Serialize sections into outfile
+	WriteSections(sections, out_file);
+
+	out_file.close();
+	if (!out_file) {
+		throw std::logic_error("Can't write file");
+	}
+	std::filesystem::rename(temp_file, file);
+}
+
+
+// Part of catalogue in section, section without other parts has routing_settings
+SectionType GetSectionType(const SerializedTransportCatalogue& section) {
+	if (section.has_render_settings()) {
+		return SectionType::RENDER_SETTINGS_SECTION;
+	}
+	if (section.stops_size() > 0) {
+		return SectionType::STOPS_SECTION;
+	}
+	if (section.buses_size() > 0) {
+		return SectionType::BUSES_SECTION;
+	}
+	if (section.bus_stats_size() > 0) {
+		return SectionType::BUS_STATS_SECTION;
+	}
+	if (section.has_distance_table()) {
+		return SectionType::DISTANCES_SECTION;
+	}
+	if (section.has_router()) {
+		return SectionType::ROUTER_SECTION;
+	}
+	return SectionType::ROUTING_SETTINGS_SECTION;
+}
+
+
+// Write index of sections, then sections one after another
+void WriteSections(const std::vector<SerializedTransportCatalogue>& sections, std::ostream& out) {
+	SerializedTransportCatalogue index;
+	for (const auto& section : sections) {
+		index.mutable_section_index()->add_section_sizes(section.ByteSizeLong());
+		index.mutable_section_index()->add_section_types(GetSectionType(section));
+	}
+	index.SerializeToOstream(&out);
+	for (const auto& section : sections) {
+		section.SerializeToOstream(&out);
+	}
+
+	if (!out) {
+		throw std::logic_error("Can't write file");
+	}
 }
 
     
@@ -125,99 +230,436 @@ SerializedRenderSettings GetSerializedRenderSettings(const RenderSettings& rende
 void SerializeRoutingSettings(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue) {
 	serialized_catalogue.set_bus_wait_time(input_catalogue.BusWaitTime());
 	serialized_catalogue.set_bus_velocity(input_catalogue.BusVelocity());
+	serialized_catalogue.set_router_type(static_cast<transport_catalogue_serialize::RouterType>(input_catalogue.GetRouterType()));
+	serialized_catalogue.set_route_graph_model(static_cast<transport_catalogue_serialize::RouteGraphModel>(input_catalogue.GetRouteGraphModel()));
+}
 
+
+// Serialize route graph, edges info and precomputed data of routing engine into new sections.
+// The first section has size of graph, every next one has ROUTER_ITEMS_IN_SECTION items of one array
+void SerializeRouter(const TransportCatalogue& input_catalogue, const SingleBusRoute& router, std::vector<SerializedTransportCatalogue>& sections) {
+	// Edges info refers to buses by their index in catalogue
+	std::unordered_map<std::string_view, uint32_t> bus_indexes;
+	const auto& buses = input_catalogue.GetAllBuses();
+	for (size_t i = 0; i < buses.size(); ++i) {
+		bus_indexes[buses.at(i).bus_number] = static_cast<uint32_t>(i);
+	}
+
+	const auto& graph = router.GetGraph();
+	sections.emplace_back().mutable_router()->mutable_graph()->set_vertex_count(graph.GetVertexCount());
+	// Sections are added below, so the first one is kept by index
+	const size_t first_section = sections.size() - 1;
+
+	// Router of section for item of array
+	const auto get_router = [&sections](size_t item) -> SerializedRouter& {
+		if (item % ROUTER_ITEMS_IN_SECTION == 0) {
+			sections.emplace_back();
+		}
+		return *sections.back().mutable_router();
+	};
+
+	const auto& edges_info = router.GetEdgesInfo();
+	for (size_t i = 0; i < graph.GetEdgeCount(); ++i) {
+		auto& serialized_graph = *get_router(i).mutable_graph();
+		const auto& edge = graph.GetEdge(i);
+		auto& serialized_edge = *serialized_graph.add_edges();
+		serialized_edge.set_from(edge.from);
+		serialized_edge.set_to(edge.to);
+		serialized_edge.set_weight(edge.weight);
+
+		auto& serialized_edge_info = *serialized_graph.add_edges_info();
+		serialized_edge_info.set_span_count(edges_info[i].stop_numb);
+		serialized_edge_info.set_bus_index(bus_indexes.at(edges_info[i].bus_name));
+		serialized_edge_info.set_type(static_cast<transport_catalogue_serialize::EdgeType>(edges_info[i].type));
+	}
+
+	// Dijkstra has nothing precomputed
+	if (const auto* floyd_warshall = dynamic_cast<const graph::Router<double>*>(&router.GetRouter())) {
+		using FloydWarshall = graph::Router<double>;
+		const auto& routes = floyd_warshall->GetRoutesInternalData();
+		sections[first_section].mutable_router()->mutable_floyd_warshall();
+		for (size_t i = 0; i < routes.weights.size(); ++i) {
+			auto& data = *get_router(i).mutable_floyd_warshall();
+			const bool has_route = routes.weights[i] != FloydWarshall::NO_ROUTE;
+			data.add_has_route(has_route);
+			data.add_weights(has_route ? routes.weights[i] : 0.0);
+			data.add_prev_edges(routes.prev_edges[i] != FloydWarshall::NO_EDGE ? routes.prev_edges[i] + 1 : 0);
+		}
+	} else if (const auto* hierarchy = dynamic_cast<const graph::ContractionHierarchy<double>*>(&router.GetRouter())) {
+		const auto [ranks, shortcuts] = hierarchy->GetHierarchy();
+		auto& first_data = *sections[first_section].mutable_router()->mutable_contraction_hierarchy();
+		for (const size_t rank : ranks) {
+			first_data.add_ranks(rank);
+		}
+		for (size_t i = 0; i < shortcuts.size(); ++i) {
+			auto& serialized_shortcut = *get_router(i).mutable_contraction_hierarchy()->add_shortcuts();
+			serialized_shortcut.set_from(shortcuts[i].from);
+			serialized_shortcut.set_to(shortcuts[i].to);
+			serialized_shortcut.set_weight(shortcuts[i].weight);
+			serialized_shortcut.set_first_child(shortcuts[i].first_child);
+			serialized_shortcut.set_second_child(shortcuts[i].second_child);
+		}
+	}
 }
 
 
 /* ********************************* DESERIALIZATION ********************************* */
 
-// Add stops SerializedTransportCatalogue into TransportCatalogue
-void DeserializeStops(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue) {
-	const auto size = serialized_catalogue.stops_size();
-	for (size_t i = 0; i < size; ++i) {
-		catalogue.AddNewStop(serialized_catalogue.stops(i).stop_name(), { serialized_catalogue.stops(i).latitude(), serialized_catalogue.stops(i).longitude() });
+// Add stops from all sections into TransportCatalogue
+void DeserializeStops(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue) {
+	for (const auto& section : sections) {
+		for (const auto& stop : section.stops()) {
+			catalogue.AddNewStop(stop.stop_name(), { stop.latitude(), stop.longitude() });
+		}
+	}
+}
+
+
+// Distances of DistanceTable from all sections. Deltas go on through all sections
+std::vector<transport::detail::RoadDistance> DecodeDistanceTables(const std::vector<SerializedTransportCatalogue>& sections, size_t stop_count) {
+	size_t distance_count = 0;
+	for (const auto& section : sections) {
+		distance_count += section.distance_table().distances_size();
+	}
+	std::vector<transport::detail::RoadDistance> distances;
+	distances.reserve(distance_count);
+
+	StopId from = 0;
+	StopId to = 0;
+	for (const auto& section : sections) {
+		const auto& table = section.distance_table();
+		if (table.to_deltas_size() != table.from_deltas_size() || table.distances_size() != table.from_deltas_size()) {
+			throw std::logic_error("Broken distance table");
+		}
+		for (int i = 0; i < table.from_deltas_size(); ++i) {
+			to = table.from_deltas(i) == 0 ? to + table.to_deltas(i) : table.to_deltas(i);
+			from += table.from_deltas(i);
+			if (from >= stop_count || to >= stop_count) {
+				throw std::logic_error("Broken distance table");
+			}
+			distances.push_back({ from, to, static_cast<int>(table.distances(i)) });
+		}
+	}
+	return distances;
+}
+
+
+// Add real distance between stops from all sections into TransportCatalogue
+void DeserializeDistancies(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue) {
+	// Base made by older version has distances with stop names
+	for (const auto& section : sections) {
+		for (const auto& distance : section.distancies()) {
+			catalogue.AddDstBetweenStops(distance.from_stop(), distance.distance(), distance.to_stop());
+		}
+	}
+
+	for (const auto& road : DecodeDistanceTables(sections, catalogue.GetAllStops().size())) {
+		catalogue.AddDstBetweenStops(road.from, road.distance, road.to);
 	}
 }
 
 
-// Add real distance between stops from SerializedTransportCatalogue into TransportCatalogue
-void DeserializeDistancies(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue) {
-	const auto size = serialized_catalogue.distancies_size();
-	for (size_t i = 0; i < size; ++i) {
-		catalogue.AddDstBetweenStops(serialized_catalogue.distancies(i).from_stop(), serialized_catalogue.distancies(i).distance(), serialized_catalogue.distancies(i).to_stop());
+// Stops of bus route by indexes, or by names in base made by older version
+std::vector<StopId> DeserializeBusRoute(const SerializedBus& serialized_bus, const TransportCatalogue& catalogue) {
+	std::vector<StopId> stops;
+	if (serialized_bus.stop_indexes_size() == 0) {
+		stops.reserve(serialized_bus.stops_at_route_size());
+		for (const auto& stop_name : serialized_bus.stops_at_route()) {
+			const auto stop = catalogue.FindStopId(stop_name);
+			if (!stop) {
+				throw std::logic_error("Broken bus route");
+			}
+			stops.push_back(*stop);
+		}
+		return stops;
 	}
+
+	stops.assign(serialized_bus.stop_indexes().begin(), serialized_bus.stop_indexes().end());
+	const auto stop_count = catalogue.GetAllStops().size();
+	for (const StopId stop : stops) {
+		if (stop >= stop_count) {
+			throw std::logic_error("Broken bus route");
+		}
+	}
+	return stops;
 }
 
-// Add all buses from SerializedTransportCatalogue into TransportCatalogue
-void DeserializeBuses(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue) {
-	const auto bus_count = serialized_catalogue.buses_size();
-	for (size_t i = 0; i < bus_count; ++i) {
-		std::vector<std::string> stops;
-		const auto stop_count = serialized_catalogue.buses(i).stops_at_route_size();
-		stops.reserve(stop_count);
 
-		for (size_t j = 0; j < stop_count; ++j) {
-			stops.push_back(serialized_catalogue.buses(i).stops_at_route(j));
+// BusStats of common type, curvature is computed from lengths
+BusStats DeserializeBusStats(const SerializedBusStats& serialized_stats) {
+	BusStats stats;
+	stats.stop_count = static_cast<int>(serialized_stats.stop_count());
+	stats.unique_stop_count = static_cast<int>(serialized_stats.unique_stop_count());
+	stats.route_length = serialized_stats.route_length();
+	stats.geo_length = serialized_stats.geo_length();
+	stats.curvature = static_cast<double>(stats.route_length / stats.geo_length);
+	return stats;
+}
+
+
+// Add all buses from sections into TransportCatalogue. Routes of sections are decoded in parallel,
+// then buses are added in order
+void DeserializeBuses(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue) {
+	// Index of the first bus of every section
+	std::vector<size_t> first_buses(sections.size() + 1, 0);
+	for (size_t i = 0; i < sections.size(); ++i) {
+		first_buses[i + 1] = first_buses[i] + sections[i].buses_size();
+	}
+
+	std::vector<std::vector<StopId>> routes(first_buses.back());
+	parallel::ForEachIndex(sections.size(), [&](size_t i) {
+		for (int j = 0; j < sections[i].buses_size(); ++j) {
+			routes[first_buses[i] + j] = DeserializeBusRoute(sections[i].buses(j), catalogue);
+		}
+	});
+
+	for (size_t i = 0; i < sections.size(); ++i) {
+		for (int j = 0; j < sections[i].buses_size(); ++j) {
+			const auto& serialized_bus = sections[i].buses(j);
+			auto& stops = routes[first_buses[i] + j];
+			const auto stop_count = stops.size();
+			const BusId bus = catalogue.AddNewBus(serialized_bus.bus_number(), std::move(stops), serialized_bus.roundtrip());
+
+			// Base made by older version has statistics inside buses or has no statistics,
+			// then they are computed on the first Bus request
+			if (serialized_bus.has_stats() && serialized_bus.stats().stop_count() == stop_count) {
+				catalogue.SetBusStats(bus, DeserializeBusStats(serialized_bus.stats()));
+			}
 		}
-	catalogue.AddNewBus(serialized_catalogue.buses(i).bus_number(), stops, serialized_catalogue.buses(i).roundtrip());
 	}
 }
 
 
-void DeserializeTransportCatalogue(const std::string file, TransportCatalogue& catalogue, RenderSettings& render_settings) {
+// Read file and split it into sections by index. Base made by older version has no index, it is one section
+SectionedBase::SectionedBase(const std::string& file) {
+	using google::protobuf::internal::WireFormatLite;
 
 	std::ifstream in_file(file, std::ios::binary);
-
 	if (!in_file.is_open()) {
 		throw std::logic_error("Can't open file");
 	}
+	data_.assign(std::istreambuf_iterator<char>(in_file), {});
+	if (data_.empty()) {
+		throw std::logic_error("Can't parse file");
+	}
+	const std::string_view data(data_);
+
+	google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data.data()), static_cast<int>(data.size()));
+	std::uint32_t index_size = 0;
+	if (input.ReadTag() != WireFormatLite::MakeTag(SerializedTransportCatalogue::kSectionIndexFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+		|| !input.ReadVarint32(&index_size)) {
+		// Base made before section index is one untyped section
+		sections_.push_back(data);
+		types_.push_back(SectionType::UNKNOWN_SECTION);
+		return;
+	}
 
-	transport_catalogue_serialize::TransportCatalogue serialized_catalogue;
-	serialized_catalogue.ParseFromIstream(&in_file);
+	transport_catalogue_serialize::SectionIndex index;
+	size_t offset = input.CurrentPosition();
+	if (index_size > data.size() - offset || !index.ParseFromArray(data.data() + offset, index_size)) {
+		throw std::logic_error("Can't parse file");
+	}
+	offset += index_size;
+
+	for (const auto section_size : index.section_sizes()) {
+		if (section_size > data.size() - offset) {
+			throw std::logic_error("Can't parse file");
+		}
+		sections_.push_back(data.substr(offset, section_size));
+		offset += section_size;
+	}
+
+	// Index made by older version has only sizes
+	types_.assign(sections_.size(), SectionType::UNKNOWN_SECTION);
+	if (index.section_types_size() == index.section_sizes_size()) {
+		for (int i = 0; i < index.section_types_size(); ++i) {
+			types_[i] = index.section_types(i);
+		}
+	}
+}
 
-	// Add stops from SerializedTransportCatalogue into TransportCatalogue
-	DeserializeStops(serialized_catalogue, catalogue);
 
-	// Add real distance between stops from SerializedTransportCatalogue into TransportCatalogue
-	DeserializeDistancies(serialized_catalogue, catalogue);
+bool SectionedBase::IsTyped() const {
+	return std::none_of(types_.begin(), types_.end(), [](SectionType type) {
+		return type == SectionType::UNKNOWN_SECTION;
+	});
+}
+
+
+std::vector<SerializedTransportCatalogue> SectionedBase::Parse(std::initializer_list<SectionType> types) const {
+	return ParseIf([types](SectionType type) {
+		return type == SectionType::UNKNOWN_SECTION || std::find(types.begin(), types.end(), type) != types.end();
+	});
+}
+
+
+std::vector<SerializedTransportCatalogue> SectionedBase::ParseAll() const {
+	return ParseIf([](SectionType) {
+		return true;
+	});
+}
+
+
+std::vector<SerializedTransportCatalogue> SectionedBase::ParseIf(std::function<bool(SectionType)> is_needed) const {
+	std::vector<std::string_view> section_data;
+	for (size_t i = 0; i < sections_.size(); ++i) {
+		if (is_needed(types_[i])) {
+			section_data.push_back(sections_[i]);
+		}
+	}
+
+	std::vector<SerializedTransportCatalogue> sections(section_data.size());
+	parallel::ForEachIndex(sections.size(), [&](size_t i) {
+		if (!sections[i].ParseFromArray(section_data[i].data(), static_cast<int>(section_data[i].size()))) {
+			throw std::logic_error("Can't parse file");
+		}
+	});
+	return sections;
+}
+
+
+// Parts which are already decoded are given away by loaders
+LazyBaseParts MakeLazyBaseParts(RenderSettings render_settings, std::unique_ptr<SingleBusRoute> router) {
+	const auto stored_settings = std::make_shared<RenderSettings>(std::move(render_settings));
+	const auto stored_router = std::make_shared<std::unique_ptr<SingleBusRoute>>(std::move(router));
+	return {
+		[stored_settings] {
+			return std::move(*stored_settings);
+		},
+		[stored_router] {
+			return std::move(*stored_router);
+		}
+	};
+}
+
+
+// Router of all router parts of sections, nullptr if there are none
+std::unique_ptr<SingleBusRoute> DeserializeRouterSections(const std::vector<SerializedTransportCatalogue>& sections, const TransportCatalogue& catalogue) {
+	std::vector<const SerializedRouter*> router_parts;
+	for (const auto& section : sections) {
+		if (section.has_router()) {
+			router_parts.push_back(&section.router());
+		}
+	}
+	if (router_parts.empty()) {
+		return nullptr;
+	}
+	return DeserializeRouter(router_parts, catalogue);
+}
+
+
+// Stops, buses and routing_settings are decoded at once, they are needed by every request.
+// Other parts of base are decoded by loaders on the first request which needs them
+LazyBaseParts DeserializeTransportCatalogueLazily(const std::string& file, TransportCatalogue& catalogue) {
+	const auto base = std::make_shared<const SectionedBase>(file);
+
+	const auto sections = base->IsTyped()
+		? base->Parse({ SectionType::ROUTING_SETTINGS_SECTION, SectionType::STOPS_SECTION, SectionType::BUSES_SECTION })
+		: base->ParseAll();
+	if (sections.empty()) {
+		throw std::logic_error("Can't parse file");
+	}
+
+	size_t stop_count = 0;
+	size_t bus_count = 0;
+	for (const auto& section : sections) {
+		stop_count += section.stops_size();
+		bus_count += section.buses_size();
+	}
+	catalogue.Reserve(stop_count, bus_count);
+
+	// Add stops from SerializedTransportCatalogue into TransportCatalogue
+	DeserializeStops(sections, catalogue);
 
 	// Add all buses from SerializedTransportCatalogue into TransportCatalogue
-	DeserializeBuses(serialized_catalogue, catalogue);
-    
-    render_settings = std::move(DeserializeRenderSettings(serialized_catalogue));
+	DeserializeBuses(sections, catalogue);
+
+	// Settings are in the first section
+	DeserializeRoutingSettings(sections.front(), catalogue);
 
-	DeserializeRoutingSettings(serialized_catalogue, catalogue);
+	// Base made by older version has no types of sections, everything is decoded now
+	if (!base->IsTyped()) {
+		DeserializeDistancies(sections, catalogue);
+		return MakeLazyBaseParts(DeserializeRenderSettings(sections.front()), DeserializeRouterSections(sections, catalogue));
+	}
+
+	// Distances are needed only to compute missing statistics or to build router
+	catalogue.RealStopDistanceData().SetLoader([base, stop_count] {
+		return DecodeDistanceTables(base->Parse({ SectionType::DISTANCES_SECTION }), stop_count);
+	});
+
+	catalogue.SetBusStatsLoader([base, &catalogue](std::vector<std::optional<BusStats>>& bus_stats) {
+		BusId bus = 0;
+		for (const auto& section : base->Parse({ SectionType::BUS_STATS_SECTION })) {
+			for (const auto& serialized_stats : section.bus_stats()) {
+				if (bus >= bus_stats.size()) {
+					throw std::logic_error("Broken bus statistics");
+				}
+				// Statistics of other route are computed again
+				if (serialized_stats.stop_count() == catalogue.GetBus(bus).bus_route.size()) {
+					bus_stats[bus] = DeserializeBusStats(serialized_stats);
+				}
+				++bus;
+			}
+		}
+		if (bus != bus_stats.size()) {
+			throw std::logic_error("Broken bus statistics");
+		}
+	});
+
+	return {
+		[base] {
+			const auto render_sections = base->Parse({ SectionType::RENDER_SETTINGS_SECTION });
+			return render_sections.empty() ? RenderSettings{} : DeserializeRenderSettings(render_sections.front());
+		},
+		[base, &catalogue] {
+			return DeserializeRouterSections(base->Parse({ SectionType::ROUTER_SECTION }), catalogue);
+		}
+	};
 }
-    
-    
+
+
+void DeserializeTransportCatalogue(const std::string file, TransportCatalogue& catalogue, RenderSettings& render_settings, std::unique_ptr<SingleBusRoute>& router) {
+	auto parts = DeserializeTransportCatalogueLazily(file, catalogue);
+	render_settings = parts.render_settings();
+	router = parts.router();
+}
+
+
 //Deserialize RenderSettings Data from Serialized TransportCatalogue Data
 RenderSettings DeserializeRenderSettings(const SerializedTransportCatalogue& serialized_catalogue) {
+    return DeserializeRenderSettings(serialized_catalogue.render_settings());
+}
+
+
+//Deserialize RenderSettings Data
+RenderSettings DeserializeRenderSettings(const SerializedRenderSettings& serialized_settings) {
     
     RenderSettings render_settings;
         
-    render_settings.width = serialized_catalogue.render_settings().width();
-    render_settings.height = serialized_catalogue.render_settings().height();
-    render_settings.padding = serialized_catalogue.render_settings().padding();
-    render_settings.line_width = serialized_catalogue.render_settings().line_width();
-    render_settings.stop_radius = serialized_catalogue.render_settings().stop_radius();
+    render_settings.width = serialized_settings.width();
+    render_settings.height = serialized_settings.height();
+    render_settings.padding = serialized_settings.padding();
+    render_settings.line_width = serialized_settings.line_width();
+    render_settings.stop_radius = serialized_settings.stop_radius();
     
-    render_settings.bus_label_font_size = serialized_catalogue.render_settings().bus_label_font_size();
-    render_settings.bus_label_offset.x = serialized_catalogue.render_settings().bus_label_offset().x();
-    render_settings.bus_label_offset.y = serialized_catalogue.render_settings().bus_label_offset().y();
+    render_settings.bus_label_font_size = serialized_settings.bus_label_font_size();
+    render_settings.bus_label_offset.x = serialized_settings.bus_label_offset().x();
+    render_settings.bus_label_offset.y = serialized_settings.bus_label_offset().y();
 
-    render_settings.stop_label_font_size = serialized_catalogue.render_settings().stop_label_font_size();
-    render_settings.stop_label_offset.x = serialized_catalogue.render_settings().stop_label_offset().x();
-    render_settings.stop_label_offset.y = serialized_catalogue.render_settings().stop_label_offset().y();
+    render_settings.stop_label_font_size = serialized_settings.stop_label_font_size();
+    render_settings.stop_label_offset.x = serialized_settings.stop_label_offset().x();
+    render_settings.stop_label_offset.y = serialized_settings.stop_label_offset().y();
     
-    render_settings.underlayer_color = serialized_catalogue.render_settings().underlayer_color();
-    render_settings.underlayer_width = serialized_catalogue.render_settings().underlayer_width(); 
+    render_settings.underlayer_color = serialized_settings.underlayer_color();
+    render_settings.underlayer_width = serialized_settings.underlayer_width(); 
     
-    const auto size = serialized_catalogue.render_settings().color_palette().size();
+    const auto size = serialized_settings.color_palette().size();
     render_settings.color_palette.reserve(size);
     
     // Fill color_palette
     for (size_t i = 0; i < size; ++i) {
-        render_settings.color_palette.push_back(serialized_catalogue.render_settings().color_palette(i));
+        render_settings.color_palette.push_back(serialized_settings.color_palette(i));
     }
     return render_settings;
 }
@@ -227,6 +669,115 @@ RenderSettings DeserializeRenderSettings(const SerializedTransportCatalogue& ser
 void DeserializeRoutingSettings(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue) {
 	catalogue.SetBusWaitTime(serialized_catalogue.bus_wait_time());
 	catalogue.SetBusVelocity(serialized_catalogue.bus_velocity());
+	catalogue.SetRouterType(static_cast<transport::detail::RouterType>(serialized_catalogue.router_type()));
+	catalogue.SetRouteGraphModel(static_cast<transport::detail::RouteGraphModel>(serialized_catalogue.route_graph_model()));
+}
+
+
+// Position of the first item of every router part in whole array, the last one is size of array
+template <typename ItemCount>
+std::vector<size_t> GetFirstItems(const std::vector<const SerializedRouter*>& router_parts, ItemCount item_count) {
+	std::vector<size_t> first_items(router_parts.size() + 1, 0);
+	for (size_t i = 0; i < router_parts.size(); ++i) {
+		first_items[i + 1] = first_items[i] + item_count(*router_parts[i]);
+	}
+	return first_items;
+}
+
+
+// Restore router for catalogue (stops, buses and routing_settings must be already deserialized).
+// Arrays of all parts are decoded in parallel into preallocated storage
+std::unique_ptr<SingleBusRoute> DeserializeRouter(const std::vector<const SerializedRouter*>& router_parts, const TransportCatalogue& catalogue) {
+	size_t vertex_count = 0;
+	for (const auto* part : router_parts) {
+		vertex_count = std::max<size_t>(vertex_count, part->graph().vertex_count());
+	}
+
+	const auto first_edges = GetFirstItems(router_parts, [](const SerializedRouter& part) {
+		return part.graph().edges_size();
+	});
+	std::vector<graph::Edge<double>> edges(first_edges.back());
+	std::vector<EdgeInfo> edges_info(first_edges.back());
+	const auto& buses = catalogue.GetAllBuses();
+	parallel::ForEachIndex(router_parts.size(), [&](size_t i) {
+		const auto& serialized_graph = router_parts[i]->graph();
+		if (serialized_graph.edges_info_size() != serialized_graph.edges_size()) {
+			throw std::logic_error("Broken route graph");
+		}
+		for (int j = 0; j < serialized_graph.edges_size(); ++j) {
+			const auto& edge = serialized_graph.edges(j);
+			const auto& edge_info = serialized_graph.edges_info(j);
+			edges[first_edges[i] + j] = { edge.from(), edge.to(), edge.weight() };
+			edges_info[first_edges[i] + j] = EdgeInfo{ static_cast<int>(edge_info.span_count()), buses.at(edge_info.bus_index()).bus_number, static_cast<EdgeType>(edge_info.type()) };
+		}
+	});
+	SingleBusRoute::Graph graph(vertex_count, std::move(edges));
+
+	const auto has_data = [&router_parts](auto has_part_data) {
+		return std::any_of(router_parts.begin(), router_parts.end(), [&has_part_data](const SerializedRouter* part) {
+			return has_part_data(*part);
+		});
+	};
+
+	// Precomputed data is used if it was stored for selected engine, otherwise engine is built from the graph
+	const auto create_router = [&](const SingleBusRoute::Graph& graph) -> std::unique_ptr<graph::RoutingEngine<double>> {
+		using RouterType = transport::detail::RouterType;
+		const auto router_type = catalogue.GetRouterType();
+
+		if (router_type == RouterType::FLOYD_WARSHALL && has_data(std::mem_fn(&SerializedRouter::has_floyd_warshall))) {
+			using FloydWarshall = graph::Router<double>;
+			const auto first_items = GetFirstItems(router_parts, [](const SerializedRouter& part) {
+				return part.floyd_warshall().has_route_size();
+			});
+			FloydWarshall::RoutesInternalData routes;
+			routes.vertex_count = graph.GetVertexCount();
+			if (first_items.back() != routes.vertex_count * routes.vertex_count) {
+				throw std::logic_error("Broken Floyd-Warshall data");
+			}
+			routes.weights.resize(first_items.back());
+			routes.prev_edges.resize(first_items.back());
+			parallel::ForEachIndex(router_parts.size(), [&](size_t i) {
+				const auto& data = router_parts[i]->floyd_warshall();
+				if (data.weights_size() != data.has_route_size() || data.prev_edges_size() != data.has_route_size()) {
+					throw std::logic_error("Broken Floyd-Warshall data");
+				}
+				for (int j = 0; j < data.has_route_size(); ++j) {
+					routes.weights[first_items[i] + j] = data.has_route(j) ? data.weights(j) : FloydWarshall::NO_ROUTE;
+					routes.prev_edges[first_items[i] + j] = data.prev_edges(j) > 0 ? data.prev_edges(j) - 1 : FloydWarshall::NO_EDGE;
+				}
+			});
+			return std::make_unique<FloydWarshall>(graph, std::move(routes));
+		}
+		if (router_type == RouterType::FLOYD_WARSHALL) {
+			return std::make_unique<graph::Router<double>>(graph);
+		}
+
+		if (router_type == RouterType::CONTRACTION_HIERARCHY && has_data(std::mem_fn(&SerializedRouter::has_contraction_hierarchy))) {
+			graph::ContractionHierarchy<double>::Hierarchy hierarchy;
+			for (const auto* part : router_parts) {
+				hierarchy.ranks.insert(hierarchy.ranks.end(), part->contraction_hierarchy().ranks().begin(), part->contraction_hierarchy().ranks().end());
+			}
+			const auto first_items = GetFirstItems(router_parts, [](const SerializedRouter& part) {
+				return part.contraction_hierarchy().shortcuts_size();
+			});
+			hierarchy.shortcuts.resize(first_items.back());
+			parallel::ForEachIndex(router_parts.size(), [&](size_t i) {
+				const auto& shortcuts = router_parts[i]->contraction_hierarchy().shortcuts();
+				for (int j = 0; j < shortcuts.size(); ++j) {
+					const auto& shortcut = shortcuts.Get(j);
+					hierarchy.shortcuts[first_items[i] + j] = { shortcut.from(), shortcut.to(), shortcut.weight(), shortcut.first_child(), shortcut.second_child() };
+				}
+			});
+			return std::make_unique<graph::ContractionHierarchy<double>>(graph, std::move(hierarchy));
+		}
+		if (router_type == RouterType::CONTRACTION_HIERARCHY) {
+			return std::make_unique<graph::ContractionHierarchy<double>>(graph);
+		}
+
+		return std::make_unique<graph::DijkstraRouter<double>>(graph);
+	};
+
+	return std::make_unique<SingleBusRoute>(catalogue, std::move(graph), std::move(edges_info), create_router);
 }
 
 } // namespace serialization_catalogue
\ No newline at end of file
@@ -5,9 +5,16 @@
 #include "transport_catalogue.h"
 
 #include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 #include <transport_catalogue.pb.h>
 #include "map_renderer.h"
+#include "transport_router.h"
 
 
 namespace serialization_catalogue {
@@ -25,29 +32,51 @@ using SerializedDistance = transport_catalogue_serialize::Distance;
 
 using SerializedRenderSettings = transport_catalogue_serialize::RenderSettings;
 
+using SerializedRouter = transport_catalogue_serialize::Router;
+
+using SerializedBusStats = transport_catalogue_serialize::BusStats;
+
+using SectionType = transport_catalogue_serialize::SectionType;
+
+// Size of sections which are parsed in parallel
+inline const size_t STOPS_IN_SECTION = 4096;
+inline const size_t ROUTE_STOPS_IN_SECTION = 32768;
+inline const size_t BUS_STATS_IN_SECTION = 4096;
+inline const size_t DISTANCES_IN_SECTION = 16384;
+inline const size_t ROUTER_ITEMS_IN_SECTION = 65536;
+
 
 /* ********************************* SERIALIZATION ********************************* */
 
 // Create a SerializedStop from common Stop
 SerializedStop SerializeSingleStop(const SingleStop& input_stop);
 
-// Serialize stops from input_catalogue to serialize_catalogue
-void SerializeStops(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue);
+// Serialize stops from input_catalogue into new sections
+void SerializeStops(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections);
+
+// Create a SerializedBus from common Bus, stops are stored by indexes and by names in compatible layout
+SerializedBus SerializeSingleBus(const TransportCatalogue& input_catalogue, BusId bus, bool compatible_layout);
 
-// Create a SerializedBus from common Bus
-SerializedBus SerializeSingleBus(const SingleBus& input_bus);
+// Serialize buses from input_catalogue into new sections
+void SerializeBuses(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections, bool compatible_layout);
 
-// Serialize buses from input_catalogue to serialize_catalogue
-void SerializeBuses(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue);
+// Serialize statistics of buses from input_catalogue into new sections, they go in order of buses
+void SerializeBusStats(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections);
 
-// Create a SerializedDistance from data
-SerializedDistance SerializeSingleDistance(const std::pair<const Stop*, const Stop*> stops, int distance);
+// Serialize real measured distancies between stops from input_catalogue into new sections as DistanceTable,
+// compatible layout has them with stop names too
+void SerializeDistancies(const TransportCatalogue& input_catalogue, std::vector<SerializedTransportCatalogue>& sections, bool compatible_layout);
 
-// Serialize real measured distancies between stops from input_catalogue to serialize_catalogue
-void SerializeDistancies(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue);
+// Serialize TransportCatalogue Data and precomputed router into file, it's written as file.tmp and renamed to file.
+// Compatible layout keeps stop names of routes and distances, so versions reading them by names load the base
+void SerializeTransportCatalogue(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const SingleBusRoute& router, const std::string& file,
+	bool compatible_layout = false);
 
-// Serialize TransportCatalogue Data into file
-void SerializeTransportCatalogue(const TransportCatalogue& catalogue, const RenderSettings& render_settings, const std::string& file);
+// Part of catalogue which section has
+SectionType GetSectionType(const SerializedTransportCatalogue& section);
+
+// Write SectionIndex with sizes and types of sections, then sections one after another
+void WriteSections(const std::vector<SerializedTransportCatalogue>& sections, std::ostream& out);
 
 // Serialize RenderSettings
 SerializedRenderSettings GetSerializedRenderSettings(const RenderSettings& render_settings);
@@ -55,27 +84,86 @@ SerializedRenderSettings GetSerializedRenderSettings(const RenderSettings& rende
 // Serialize routing_settings
 void SerializeRoutingSettings(const TransportCatalogue& input_catalogue, SerializedTransportCatalogue& serialized_catalogue);
 
+// Serialize route graph, edges info and precomputed data of routing engine into new sections
+void SerializeRouter(const TransportCatalogue& input_catalogue, const SingleBusRoute& router, std::vector<SerializedTransportCatalogue>& sections);
+
 
 /* ********************************* DESERIALIZATION ********************************* */
 
-// Add stops from serialized data from SerializedTransportCatalogue into TransportCatalogue
-void DeserializeStops(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue);
+// Base file split into sections by SectionIndex, sections are parsed only when they are needed.
+// Text of file is kept until the object is destroyed. Base without index is one section
+class SectionedBase {
+public:
+	explicit SectionedBase(const std::string& file);
+
+	SectionedBase(const SectionedBase&) = delete;
+	SectionedBase& operator=(const SectionedBase&) = delete;
+
+	// Base made by older version has no types of sections, any section may have any part of catalogue
+	bool IsTyped() const;
+
+	// Parse sections of given types in parallel, they go in order of file. Section without type has any type
+	std::vector<SerializedTransportCatalogue> Parse(std::initializer_list<SectionType> types) const;
 
-// Add real distance between stops from SerializedTransportCatalogue into TransportCatalogue
-void DeserializeDistancies(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue);
+	// Parse all sections in parallel
+	std::vector<SerializedTransportCatalogue> ParseAll() const;
 
+private:
+	std::vector<SerializedTransportCatalogue> ParseIf(std::function<bool(SectionType)> is_needed) const;
 
-// Add all buses from SerializedTransportCatalogue into TransportCatalogue
-void DeserializeBuses(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue);
+	std::string data_;
+	std::vector<std::string_view> sections_;
+	std::vector<SectionType> types_;
+};
 
-//Deserialize TransportCatalogue Data from Serialized TransportCatalogue Data file
-void DeserializeTransportCatalogue(const std::string file, TransportCatalogue& catalogue, RenderSettings& render_settings);
+// Parts of base which are decoded on the first call, every function is called only once
+struct LazyBaseParts {
+	std::function<RenderSettings()> render_settings;
+	// nullptr if base was made without router
+	std::function<std::unique_ptr<SingleBusRoute>()> router;
+};
+
+// Parts which are already decoded
+LazyBaseParts MakeLazyBaseParts(RenderSettings render_settings, std::unique_ptr<SingleBusRoute> router);
+
+// Add stops from all sections into TransportCatalogue
+void DeserializeStops(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue);
+
+// Distances of DistanceTable from all sections in order of sections, stops are checked by stop_count
+std::vector<transport::detail::RoadDistance> DecodeDistanceTables(const std::vector<SerializedTransportCatalogue>& sections, size_t stop_count);
+
+// Add real distance between stops from all sections into TransportCatalogue, both layouts are read
+void DeserializeDistancies(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue);
+
+// Stops of bus route, both layouts are read. Stops must be already deserialized
+std::vector<StopId> DeserializeBusRoute(const SerializedBus& serialized_bus, const TransportCatalogue& catalogue);
+
+// BusStats of common type, curvature is computed from lengths
+BusStats DeserializeBusStats(const SerializedBusStats& serialized_stats);
+
+// Add all buses from all sections into TransportCatalogue, routes are decoded in parallel
+void DeserializeBuses(const std::vector<SerializedTransportCatalogue>& sections, TransportCatalogue& catalogue);
+
+// Deserialize stops, buses and routing_settings from file at once. Distances and statistics of buses
+// are set as loaders of catalogue, render settings and router are returned as loaders too.
+// Loaders keep the file text, base made by older version is decoded at once.
+// Catalogue must live while loaders are used
+LazyBaseParts DeserializeTransportCatalogueLazily(const std::string& file, TransportCatalogue& catalogue);
+
+//Deserialize TransportCatalogue Data and router from Serialized TransportCatalogue Data file
+//router is nullptr if base file was made without it
+void DeserializeTransportCatalogue(const std::string file, TransportCatalogue& catalogue, RenderSettings& render_settings, std::unique_ptr<SingleBusRoute>& router);
 
 //Deserialize RenderSettings Data from Serialized TransportCatalogue Data
 RenderSettings DeserializeRenderSettings(const SerializedTransportCatalogue& serialized_catalogue);
+RenderSettings DeserializeRenderSettings(const SerializedRenderSettings& serialized_settings);
 
 // Deserialize routing_settings
 void DeserializeRoutingSettings(const SerializedTransportCatalogue& serialized_catalogue, TransportCatalogue& catalogue);
 
+// Restore router for catalogue (stops, buses and routing_settings must be already deserialized)
+// Router is split into parts in order of sections
+std::unique_ptr<SingleBusRoute> DeserializeRouter(const std::vector<const SerializedRouter*>& router_parts, const TransportCatalogue& catalogue);
+
 
 } // name space serialization_catalogue
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace serialization_catalogue {
+
+using namespace std::literals;
+
+namespace {
+
+// Remove line breaks of printed JSON, line breaks inside strings are escaped
+std::string MakeLine(std::string text) {
+	text.erase(std::remove(text.begin(), text.end(), '\n'), text.end());
+	return text;
+}
+
+// Print node without line breaks
+std::string PrintLine(const json::Node& node) {
+	return MakeLine(json::Print(node));
+}
+
+// Write whole data into socket, false if connection is closed
+bool SendAll(int connection, const std::string& data) {
+	size_t sent = 0;
+	while (sent < data.size()) {
+		const ssize_t count = send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (count <= 0) {
+			return false;
+		}
+		sent += static_cast<size_t>(count);
+	}
+	return true;
+}
+
+} // namespace
+
+
+std::shared_ptr<LoadedBase> RequestServer::GetBase(const std::string& file_name, size_t route_cache_size) {
+	const auto file_time = std::filesystem::last_write_time(file_name);
+	{
+		std::lock_guard guard(mutex_);
+		if (base_ && file_name_ == file_name && (file_time_ == file_time || failed_file_time_ == file_time)) {
+			return base_;
+		}
+	}
+
+	std::unique_lock reload_guard(reload_mutex_, std::defer_lock);
+	{
+		std::lock_guard guard(mutex_);
+		// File has changed while old base is loaded: other thread is loading new one, old base still works
+		if (base_ && file_name_ == file_name && !reload_guard.try_lock()) {
+			return base_;
+		}
+	}
+	if (!reload_guard.owns_lock()) {
+		reload_guard.lock();
+	}
+
+	// Other thread could load the same file meanwhile
+	{
+		std::lock_guard guard(mutex_);
+		if (base_ && file_name_ == file_name && (file_time_ == file_time || failed_file_time_ == file_time)) {
+			return base_;
+		}
+	}
+
+	std::shared_ptr<LoadedBase> base;
+	try {
+		base = LoadBase(file_name, route_cache_size);
+	} catch (const std::exception& error) {
+		// Broken file keeps old base, it is read again only when the file changes
+		std::lock_guard guard(mutex_);
+		if (!base_ || file_name_ != file_name) {
+			throw;
+		}
+		std::cerr << "Can't reload "s << file_name << ": "s << error.what() << '\n';
+		failed_file_time_ = file_time;
+		return base_;
+	}
+
+	std::lock_guard guard(mutex_);
+	base_ = base;
+	file_name_ = file_name;
+	file_time_ = file_time;
+	failed_file_time_.reset();
+	return base;
+}
+
+
+std::string RequestServer::AnswerLine(const std::string& line) {
+	try {
+		const json::ArenaDocument document(line);
+		const std::string file_name(document.GetRoot().AsMap().at("serialization_settings"s).AsMap().at("file"s).AsString());
+		const auto base = GetBase(file_name, GetRouteCacheSize(document));
+		std::ostringstream answers;
+		PrintRequestAnswers(answers, base->catalogue, document, *base, GetThreadCount(document));
+		return MakeLine(answers.str());
+	} catch (const std::exception& error) {
+		return PrintLine(json::Dict{{"error_message"s, json::Node(std::string(error.what()))}});
+	}
+}
+
+
+void RequestServer::Serve(std::istream& input, std::ostream& out) {
+	for (std::string line; std::getline(input, line);) {
+		if (line.find_first_not_of(" \t\r"s) == std::string::npos) {
+			continue;
+		}
+		out << AnswerLine(line) << std::endl;
+	}
+}
+
+
+void RequestServer::ServeConnection(int connection) {
+	std::string buffer;
+	char chunk[1 << 16];
+	for (ssize_t count; (count = recv(connection, chunk, sizeof(chunk), 0)) > 0;) {
+		buffer.append(chunk, static_cast<size_t>(count));
+		size_t line_begin = 0;
+		for (size_t line_end; (line_end = buffer.find('\n', line_begin)) != std::string::npos; line_begin = line_end + 1) {
+			const std::string line = buffer.substr(line_begin, line_end - line_begin);
+			if (line.find_first_not_of(" \t\r"s) == std::string::npos) {
+				continue;
+			}
+			if (!SendAll(connection, AnswerLine(line) + '\n')) {
+				close(connection);
+				return;
+			}
+		}
+		buffer.erase(0, line_begin);
+	}
+	close(connection);
+}
+
+
+void RequestServer::ServeSocket(const std::string& socket_path) {
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		throw std::invalid_argument("Socket path is too long"s);
+	}
+	std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		throw std::system_error(errno, std::generic_category(), "Can't create socket"s);
+	}
+	// Socket file left by previous run
+	unlink(socket_path.c_str());
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+		const int error = errno;
+		close(listener);
+		throw std::system_error(error, std::generic_category(), "Can't listen on "s + socket_path);
+	}
+
+	while (true) {
+		const int connection = accept(listener, nullptr, nullptr);
+		if (connection < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			const int error = errno;
+			close(listener);
+			throw std::system_error(error, std::generic_category(), "Can't accept connection"s);
+		}
+		std::thread([this, connection]() { ServeConnection(connection); }).detach();
+	}
+}
+
+
+void Serve(const std::string& socket_path) {
+	RequestServer server;
+	if (socket_path.empty()) {
+		server.Serve();
+	} else {
+		server.ServeSocket(socket_path);
+	}
+}
+
+} // namespace serialization_catalogue
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "json.h"
+#include "request_handler.h"
+
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+
+namespace serialization_catalogue {
+
+/* ********************************* SERVER MODE ********************************* */
+
+// Answers a stream of process_requests documents, one document per line (NDJSON), one answer per line.
+// Base is deserialized once and reloaded when its file changes: new base is built aside
+// and replaces the old one, requests in progress finish with the old base
+class RequestServer {
+public:
+    // Answer one request document, answer has no line breaks.
+    // Errors are returned as {"error_message": ...} and don't stop the server
+    std::string AnswerLine(const std::string& line);
+
+    // Answer every line of input until it ends
+    void Serve(std::istream& input = std::cin, std::ostream& out = std::cout);
+
+    // Accept connections on Unix domain socket, every connection is served like a stream of lines
+    void ServeSocket(const std::string& socket_path);
+
+private:
+    // Base for file_name, it is loaded if it isn't loaded yet or file has changed
+    std::shared_ptr<LoadedBase> GetBase(const std::string& file_name, size_t route_cache_size);
+
+    void ServeConnection(int connection);
+
+    std::mutex mutex_;
+    std::shared_ptr<LoadedBase> base_;
+    std::string file_name_;
+    std::filesystem::file_time_type file_time_;
+    // Time of file_name_ which failed to load, it isn't read again until the file changes
+    std::optional<std::filesystem::file_time_type> failed_file_time_;
+
+    // Only one thread loads base, others keep using the old one until it is replaced
+    std::mutex reload_mutex_;
+};
+
+// Run server: requests are read from stdin or from Unix domain socket if socket_path isn't empty
+void Serve(const std::string& socket_path = {});
+
+} // namespace serialization_catalogue
@@ -1,51 +1,96 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace transport {
    
 namespace catalogue { 
     
 using namespace std;
 
+void TransportCatalogue::Reserve(size_t stop_count, size_t bus_count) {
+    stop_ids_.reserve(stop_count);
+    stop_points_.reserve(stop_count);
+    buses_for_stop_.reserve(stop_count);
+    bus_ids_.reserve(bus_count);
+    bus_stats_.reserve(bus_count);
+}
+
+
 // Adds New Stop 
-void TransportCatalogue::AddNewStop(const std::string& stop_name, const detail::Coordinates& coordinates) {
-    stops_.push_back({stop_name, coordinates});
-    stops_pointers_[stops_.back().stop_name] = &(stops_.back());
+StopId TransportCatalogue::AddNewStop(std::string_view stop_name, const detail::Coordinates& coordinates) {
+    const auto id = static_cast<StopId>(stops_.size());
+    stops_.push_back({std::string(stop_name), coordinates});
+    stop_ids_[stops_.back().stop_name] = id;
+    stop_points_.Add(coordinates);
+    buses_for_stop_.emplace_back();
+    return id;
 }
 
 
 // Adds New Bus
-void TransportCatalogue::AddNewBus(const string& bus_name, const vector<string>& stops, bool is_roundtrip = false) {
-    vector<string_view> stops_view;
-    stops_view.reserve(stops.size());
-    
+BusId TransportCatalogue::AddNewBus(string_view bus_name, const vector<string_view>& stops, bool is_roundtrip) {
+    vector<StopId> stop_ids;
+    stop_ids.reserve(stops.size());
     for (const auto& stop : stops) {
-        stops_view.push_back(stops_pointers_.find(stop)->first);
+        stop_ids.push_back(stop_ids_.at(stop));
     }
-    
-    buses_.push_back({ bus_name , stops_view, is_roundtrip});
-    bus_pointers_[buses_.back().bus_number] = &(buses_.back());
+    return AddNewBus(bus_name, move(stop_ids), is_roundtrip);
+}
+
+
+BusId TransportCatalogue::AddNewBus(const string& bus_name, const vector<string>& stops, bool is_roundtrip) {
+    return AddNewBus(string_view(bus_name), vector<string_view>(stops.begin(), stops.end()), is_roundtrip);
+}
+
+
+BusId TransportCatalogue::AddNewBus(string_view bus_name, vector<StopId> stops, bool is_roundtrip) {
+    const auto id = static_cast<BusId>(buses_.size());
+    buses_.push_back({ std::string(bus_name), move(stops), is_roundtrip});
+    const Bus& bus = buses_.back();
+    bus_ids_[bus.bus_number] = id;
+    bus_stats_.emplace_back();
+    bus_stats_ready_.store(false, memory_order_relaxed);
     
     // Fill buses_for_stop_ with stops and buses 
-    for (const auto &stop_view : stops_view) {
-        buses_for_stop_[stop_view].insert(buses_.back().bus_number);
+    for (const StopId stop : bus.bus_route) {
+        buses_for_stop_.at(stop).insert(bus.bus_number);
+    }
+    return id;
+}
+
+
+optional<StopId> TransportCatalogue::FindStopId(string_view stop_name) const {
+    if (const auto it = stop_ids_.find(stop_name); it != stop_ids_.end()) {
+        return it->second;
+    }
+    return nullopt;
+}
+
+
+optional<BusId> TransportCatalogue::FindBusId(string_view bus_name) const {
+    if (const auto it = bus_ids_.find(bus_name); it != bus_ids_.end()) {
+        return it->second;
     }
+    return nullopt;
 }
 
 
 // Find Bus route
-const vector<string_view>& TransportCatalogue::FindBus(const string& bus_name) const {
-    if (bus_pointers_.count(bus_name) > 0) {
-        return bus_pointers_.at(bus_name)->bus_route;
+const vector<StopId>& TransportCatalogue::FindBus(string_view bus_name) const {
+    if (const auto bus = FindBusId(bus_name)) {
+        return buses_[*bus].bus_route;
     }
-    static vector<string_view> empty_vector;
+    static vector<StopId> empty_vector;
     return empty_vector;
 }
   
     
 // Return ptr to definite Bus
 const Bus* TransportCatalogue::FindBusPtr(const std::string_view& bus_name) const {
-    if (bus_pointers_.count(bus_name) > 0) {
-        return bus_pointers_.at(bus_name);
+    if (const auto bus = FindBusId(bus_name)) {
+        return &buses_[*bus];
     }
     static Bus empty_bus;
     return &empty_bus;
@@ -54,8 +99,8 @@ const Bus* TransportCatalogue::FindBusPtr(const std::string_view& bus_name) cons
     
 // Find Stop of bus
 const Stop& TransportCatalogue::FindStop(const string_view& stop_name) const {
-    if(stops_pointers_.count(stop_name) > 0) {
-        return *(stops_pointers_.at(stop_name)); 
+    if (const auto stop = FindStopId(stop_name)) {
+        return stops_[*stop];
     }
     static Stop empty_stop;
     return empty_stop;   
@@ -64,8 +109,8 @@ const Stop& TransportCatalogue::FindStop(const string_view& stop_name) const {
 
 // Find all buses which go through single stop
 const set<string_view>& TransportCatalogue::FindBusesAtStop(const string_view& stop_name) const {
-    if (buses_for_stop_.count(stop_name) > 0) {
-        return buses_for_stop_.at(stop_name);
+    if (const auto stop = FindStopId(stop_name)) {
+        return buses_for_stop_[*stop];
     }
     static set<string_view> empty_set;
     return empty_set;
@@ -73,41 +118,86 @@ const set<string_view>& TransportCatalogue::FindBusesAtStop(const string_view& s
 
 
 // Add real Distance between Stops
-void TransportCatalogue::AddDstBetweenStops(const string& stop1, const int dist, const string& stop2) {
-    distance_between_stops_[std::make_pair(stops_pointers_.at(stop1), stops_pointers_.at(stop2))] = dist;
+void TransportCatalogue::AddDstBetweenStops(string_view stop1, const int dist, string_view stop2) {
+    AddDstBetweenStops(stop_ids_.at(stop1), dist, stop_ids_.at(stop2));
+}
+
+
+void TransportCatalogue::AddDstBetweenStops(StopId stop1, const int dist, StopId stop2) {
+    distance_between_stops_.Add(stop1, stop2, dist);
 }
 
 
 // Return real measured distance between stops
-int TransportCatalogue::StopToStopDst(const string_view& from_stop1, const string_view& to_stop2) const {
-    if (distance_between_stops_.count({stops_pointers_.at(from_stop1), stops_pointers_.at(to_stop2)}) > 0) {
-        return distance_between_stops_.at({stops_pointers_.at(from_stop1), stops_pointers_.at(to_stop2)});
-    } 
-    return distance_between_stops_.at({stops_pointers_.at(to_stop2), stops_pointers_.at(from_stop1)});
+int TransportCatalogue::StopToStopDst(StopId from_stop1, StopId to_stop2) const {
+    if (const auto distance = distance_between_stops_.Find(from_stop1, to_stop2)) {
+        return *distance;
+    }
+    throw out_of_range("No distance between stops "s + stops_[from_stop1].stop_name + " and "s + stops_[to_stop2].stop_name);
 }
 
 // Return real measured distance between stops if road between stops exists
-optional<int> TransportCatalogue::RealStopsDistance(const string_view& from_stop1, const string_view& to_stop2) const {
-    if (distance_between_stops_.count({ stops_pointers_.at(from_stop1), stops_pointers_.at(to_stop2) }) > 0) {
-        return distance_between_stops_.at({ stops_pointers_.at(from_stop1), stops_pointers_.at(to_stop2) });
-    }
-    else {
-        return nullopt;
-    }
+optional<int> TransportCatalogue::RealStopsDistance(StopId from_stop1, StopId to_stop2) const {
+    return distance_between_stops_.FindMeasured(from_stop1, to_stop2);
 }
     
 // Compute route lenght by GPS-coordinate and real measured distancies
-detail::Distance TransportCatalogue::ComputeRouteDistance(const std::vector<std::string_view>& stops) const noexcept {
-	double gps_dist{ 0 };
+detail::Distance TransportCatalogue::ComputeRouteDistance(const std::vector<StopId>& stops) const noexcept {
+	const double gps_dist = stop_points_.RouteLength(stops);
     int real_dist{ 0 };
     
 	for (size_t i = 1; i < stops.size(); i++) {
-        gps_dist += transport::detail::ComputeDistance({FindStop(stops.at(i - 1)).coordinates.lat, FindStop(stops.at(i - 1)).coordinates.lng }, 
-                                    { FindStop(stops.at(i)).coordinates.lat, FindStop(stops.at(i)).coordinates.lng });
-        real_dist += StopToStopDst(stops.at(i - 1), stops.at(i));
+        real_dist += StopToStopDst(stops[i - 1], stops[i]);
     }
 	return {gps_dist, real_dist};
 }
+
+
+const BusStats& TransportCatalogue::GetBusStats(BusId bus) const {
+    if (!bus_stats_ready_.load(memory_order_acquire)) {
+        lock_guard guard(bus_stats_mutex_);
+        if (!bus_stats_ready_.load(memory_order_relaxed)) {
+            if (bus_stats_loader_) {
+                bus_stats_loader_(bus_stats_);
+                bus_stats_loader_ = nullptr;
+            }
+            for (BusId id = 0; id < buses_.size(); ++id) {
+                if (!bus_stats_[id]) {
+                    bus_stats_[id] = ComputeBusStats(buses_[id]);
+                }
+            }
+            bus_stats_ready_.store(true, memory_order_release);
+        }
+    }
+    return *bus_stats_.at(bus);
+}
+
+
+void TransportCatalogue::SetBusStats(BusId bus, const BusStats& stats) {
+    bus_stats_.at(bus) = stats;
+}
+
+
+void TransportCatalogue::SetBusStatsLoader(BusStatsLoader loader) {
+    bus_stats_loader_ = move(loader);
+    bus_stats_ready_.store(false, memory_order_relaxed);
+}
+
+
+BusStats TransportCatalogue::ComputeBusStats(const Bus& bus) const {
+    vector<StopId> unique_stops(bus.bus_route);
+    sort(unique_stops.begin(), unique_stops.end());
+    unique_stops.erase(unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+
+    const auto distances = ComputeRouteDistance(bus.bus_route);
+    BusStats stats;
+    stats.stop_count = static_cast<int>(bus.bus_route.size());
+    stats.unique_stop_count = static_cast<int>(unique_stops.size());
+    stats.route_length = distances.real_dist;
+    stats.geo_length = distances.gps_dist;
+    stats.curvature = static_cast<double>(distances.real_dist / distances.gps_dist);
+    return stats;
+}
     
 } // End namespace catalogue   
     
@@ -1,13 +1,17 @@
 #pragma once
 
 #include <set>
+#include <atomic>
 #include <deque>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <functional>
 #include <string_view>
 #include <unordered_map>
 #include "geo.h"
+#include "road_distances.h"
 #include <optional>
 
 /*TESTING NEW memebrs*/
@@ -19,6 +23,9 @@ namespace transport {
 
 namespace detail {
 
+// Handles of stops and buses: index in order of adding into catalogue, StopId is declared with RoadDistances
+using BusId = std::uint32_t;
+
 // Single Stop
 struct Stop {
     std::string stop_name = "";
@@ -38,7 +45,7 @@ struct Stop {
 // Single Bus
 struct Bus {
     std::string bus_number = "";
-    std::vector<std::string_view> bus_route;
+    std::vector<StopId> bus_route;
     bool is_roundtrip = false;
 
     bool IsEmtyBus() const {
@@ -48,16 +55,30 @@ struct Bus {
 }; // End of struct Stop
 
 
-// Stop to Stop Hasher
-struct StopToStopHasher {
-    std::size_t operator() (const std::pair<const Stop*, const Stop*>& stops_pair) const {
-        return ptr_hasher(stops_pair.first) * 3 + ptr_hasher(stops_pair.second) * 3 * 3;
-    }
+// Statistics of bus route for Bus requests, they depend only on base data
+struct BusStats {
+    int stop_count = 0;
+    int unique_stop_count = 0;
+    int route_length = 0;       // by real measured distances
+    double geo_length = 0.0;    // by GPS-coordinates
+    double curvature = 0.0;
+};
 
-private:
-    std::hash<const void*> ptr_hasher;
 
-}; //End of struct StopToStopHasher
+// Engine used to build routes between stops
+enum class RouterType {
+    FLOYD_WARSHALL,     // all-pairs precomputation, fastest queries, O(V^2) memory
+    DIJKSTRA,           // nothing precomputed, every query searches the graph
+    CONTRACTION_HIERARCHY   // shortcuts precomputed once, queries search a small part of the graph
+};
+
+
+// Structure of graph used for routing
+enum class RouteGraphModel {
+    COMPLETE,           // edge from every stop to every next stop of bus, O(n^2) edges per bus
+    COMPACT             // vertex for every stop of bus, boarding/ride/alighting edges, O(n) edges per bus
+};
+
 
 } // End namespace detail 
 
@@ -65,7 +86,11 @@ namespace catalogue {
 
 using Bus = detail::Bus;
 using Stop = detail::Stop;
-using StopToStopHasher = detail::StopToStopHasher;
+using StopId = detail::StopId;
+using BusId = detail::BusId;
+using BusStats = detail::BusStats;
+using RouterType = detail::RouterType;
+using RouteGraphModel = detail::RouteGraphModel;
 
 class TransportCatalogue {
 
@@ -74,14 +99,31 @@ public:
     TransportCatalogue() = default;
     ~TransportCatalogue() {}
 
-    // Adds New Stop    
-    void AddNewStop(const std::string& stop_name, const detail::Coordinates& coordinates);
+    // Reserve memory for stops and buses which are going to be added, e.g. when base is loaded
+    void Reserve(size_t stop_count, size_t bus_count);
 
-    // Adds New Bus
-    void AddNewBus(const std::string& bus_name, const std::vector<std::string>& stops, bool is_roundtrip);
+    // Adds New Stop, name is copied into catalogue. Returns id of the stop
+    StopId AddNewStop(std::string_view stop_name, const detail::Coordinates& coordinates);
 
-    // Return vector of stops names
-    const std::vector<std::string_view>& FindBus(const std::string& bus_name) const;
+    // Adds New Bus, stops should be already added. Returns id of the bus
+    BusId AddNewBus(std::string_view bus_name, const std::vector<std::string_view>& stops, bool is_roundtrip);
+    BusId AddNewBus(const std::string& bus_name, const std::vector<std::string>& stops, bool is_roundtrip);
+    BusId AddNewBus(std::string_view bus_name, std::vector<StopId> stops, bool is_roundtrip);
+
+    // Id of stop or bus by name, names are hashed only here
+    std::optional<StopId> FindStopId(std::string_view stop_name) const;
+    std::optional<BusId> FindBusId(std::string_view bus_name) const;
+
+    const Stop& GetStop(StopId stop) const {
+        return stops_[stop];
+    }
+
+    const Bus& GetBus(BusId bus) const {
+        return buses_[bus];
+    }
+
+    // Return stops of bus route, empty for unknown bus
+    const std::vector<StopId>& FindBus(std::string_view bus_name) const;
 
     // Return ptr to definite Bus
     const Bus* FindBusPtr(const std::string_view& bus_name) const;
@@ -91,18 +133,34 @@ public:
 
     // Find all buses which go through single stop
     const std::set<std::string_view>& FindBusesAtStop(const std::string_view& stop_name) const;
+    const std::set<std::string_view>& FindBusesAtStop(StopId stop) const {
+        return buses_for_stop_[stop];
+    }
 
     // Add real Distance between Stops
-    void AddDstBetweenStops(const std::string& stop1, const int dist, const std::string& stop2);
+    void AddDstBetweenStops(std::string_view stop1, const int dist, std::string_view stop2);
+    void AddDstBetweenStops(StopId stop1, const int dist, StopId stop2);
 
-    // Return real measured distance between stops
-    int StopToStopDst(const std::string_view& from_stop1, const std::string_view& to_stop2) const;
+    // Return real measured distance between stops, distance of back direction is used if there is no direct one
+    int StopToStopDst(StopId from_stop1, StopId to_stop2) const;
     
     // Return real measured distance between stops if road exists
-    std::optional<int> RealStopsDistance(const std::string_view& from_stop1, const std::string_view& to_stop2) const;
+    std::optional<int> RealStopsDistance(StopId from_stop1, StopId to_stop2) const;
 
     // Compute route lenght by GPS-coordinate and real measured distancies
-    detail::Distance ComputeRouteDistance(const std::vector<std::string_view>& stops) const noexcept;
+    detail::Distance ComputeRouteDistance(const std::vector<StopId>& stops) const noexcept;
+
+    // Statistics of bus route. Buses without stored statistics get them all at once on the first call,
+    // next calls only read them. May be called concurrently
+    const BusStats& GetBusStats(BusId bus) const;
+
+    // Use statistics stored in base instead of computing them
+    void SetBusStats(BusId bus, const BusStats& stats);
+
+    // Statistics are got from loader on the first call of GetBusStats, e.g. when they are decoded from base on demand.
+    // Loader sets statistics by BusId, buses it leaves without them are computed
+    using BusStatsLoader = std::function<void(std::vector<std::optional<BusStats>>& bus_stats)>;
+    void SetBusStatsLoader(BusStatsLoader loader);
 
     // Get access to all buses
     const std::deque<Bus>& GetAllBuses() const {
@@ -124,6 +182,16 @@ public:
         bus_velocity_ = velocity;
     }
 
+    // Set an engine for building routes
+    void SetRouterType(RouterType router_type) {
+        router_type_ = router_type;
+    }
+
+    // Set a structure of graph used for routing
+    void SetRouteGraphModel(RouteGraphModel route_graph_model) {
+        route_graph_model_ = route_graph_model;
+    }
+
     int BusWaitTime() const {
         return bus_wait_time_;
     }
@@ -131,31 +199,56 @@ public:
     int BusVelocity() const {
         return bus_velocity_;
     }
+
+    RouterType GetRouterType() const {
+        return router_type_;
+    }
+
+    RouteGraphModel GetRouteGraphModel() const {
+        return route_graph_model_;
+    }
     
     // Get access to real distance between stops
-    const std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopToStopHasher>& RealStopDistanceData() const {
+    const detail::RoadDistances& RealStopDistanceData() const {
+        return distance_between_stops_;
+    }
+
+    // Road distances are assigned at once when base is loaded
+    detail::RoadDistances& RealStopDistanceData() {
         return distance_between_stops_;
     }
     
 private:
 
-    // Variable for STOPs holding and searching
+    BusStats ComputeBusStats(const Bus& bus) const;
+
+    // Variable for STOPs holding and searching, index is StopId
     std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, const Stop*> stops_pointers_;
+    std::unordered_map<std::string_view, StopId> stop_ids_;
+    // Coordinates of stops with precomputed trigonometry, index is StopId
+    detail::GeoPoints stop_points_;
 
-    // Variable for BUSes holding and searching
+    // Variable for BUSes holding and searching, index is BusId
     std::deque<Bus> buses_;
-    std::unordered_map<std::string_view, const Bus*> bus_pointers_;
+    std::unordered_map<std::string_view, BusId> bus_ids_;
+
+    // Statistics of buses, index is BusId
+    mutable std::vector<std::optional<BusStats>> bus_stats_;
+    mutable BusStatsLoader bus_stats_loader_;
+    mutable std::atomic<bool> bus_stats_ready_ = true;
+    mutable std::mutex bus_stats_mutex_;
 
-    // Variable for Stop X (New Request)
-    std::unordered_map<std::string_view, std::set<std::string_view>> buses_for_stop_;
+    // Variable for Stop X (New Request), index is StopId
+    std::vector<std::set<std::string_view>> buses_for_stop_;
 
     // Real measured distance between Stops
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopToStopHasher> distance_between_stops_;
+    detail::RoadDistances distance_between_stops_;
 
     // routing_settings
     int bus_wait_time_ = 0;
     double bus_velocity_ = 0.0;
+    RouterType router_type_ = RouterType::FLOYD_WARSHALL;
+    RouteGraphModel route_graph_model_ = RouteGraphModel::COMPLETE;
 
 
 
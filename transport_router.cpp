@@ -1,4 +1,5 @@
 #include "transport_router.h"
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -7,11 +8,12 @@
 using namespace std;
 
 using Bus = transport::detail::Bus;
+using StopId = transport::detail::StopId;
 using VertexId = size_t;
-using RouteInfo = graph::Router<double>::RouteInfo;
+using RouteInfo = graph::RoutingEngine<double>::RouteInfo;
 
 // Fill graph with STRAIGHT bus trip info avoiding creating excessive edges
-void SingleBusRoute::ProcessStraightBusRoute(const Bus& bus, const vector<string_view>& stops, size_t stops_size) {
+void SingleBusRoute::ProcessStraightBusRoute(const Bus& bus, const vector<StopId>& stops, size_t stops_size) {
     const auto bus_velocity = catalogue.BusVelocity();
     
     // Proccess all stops till middle
@@ -20,8 +22,8 @@ void SingleBusRoute::ProcessStraightBusRoute(const Bus& bus, const vector<string
         auto prev_stop = stops.at(i);
         for (int j = i + 1; j <= stops_size / 2; ++j) {
             current_time += ((catalogue.StopToStopDst(prev_stop, stops.at(j)) / 1000.0f) / bus_velocity) * 60;
-            const auto edge_id = route_graph.AddEdge({ stops_vertex.at(stops.at(i)), stops_vertex.at(stops.at(j)), current_time });
-            edge_stop_count_[edge_id] = EdgeInfo{ j - i, bus.bus_number };
+            route_graph.AddEdge({ stops.at(i), stops.at(j), current_time });
+            edges_info_.push_back(EdgeInfo{ j - i, bus.bus_number });
             prev_stop = stops.at(j);
         }
     }  
@@ -32,8 +34,8 @@ void SingleBusRoute::ProcessStraightBusRoute(const Bus& bus, const vector<string
     auto prev_stop = stops.at(i);
         for (int j = i + 1; j < stops_size; ++j) {
             current_time += ((catalogue.StopToStopDst(prev_stop, stops.at(j)) / 1000.0f) / bus_velocity) * 60;
-            const auto edge_id = route_graph.AddEdge({ stops_vertex.at(stops.at(i)), stops_vertex.at(stops.at(j)), current_time });
-            edge_stop_count_[edge_id] = EdgeInfo{ j - i, bus.bus_number };
+            route_graph.AddEdge({ stops.at(i), stops.at(j), current_time });
+            edges_info_.push_back(EdgeInfo{ j - i, bus.bus_number });
             prev_stop = stops.at(j);
         }
     }
@@ -41,65 +43,322 @@ void SingleBusRoute::ProcessStraightBusRoute(const Bus& bus, const vector<string
 
 
 // Fill graph with ROUND bus trip info avoiding creating excessive edges (but create  1 excessive edge first stop -> first stop)
-void SingleBusRoute::ProcessRoundBusRoute(const Bus& bus, const vector<string_view>& stops, size_t stops_size) {
+void SingleBusRoute::ProcessRoundBusRoute(const Bus& bus, const vector<StopId>& stops, size_t stops_size) {
     const auto bus_velocity = catalogue.BusVelocity();
     for (int i = 0; i + 1 < stops_size; ++i) {
         double current_time = catalogue.BusWaitTime();
         auto prev_stop = stops.at(i);
         for (int j = i + 1; j < stops_size; ++j) {
             current_time += ((catalogue.StopToStopDst(prev_stop, stops.at(j)) / 1000.0f) / bus_velocity) * 60;
-            const auto edge_id = route_graph.AddEdge({ stops_vertex.at(stops.at(i)), stops_vertex.at(stops.at(j)), current_time });
-            edge_stop_count_[edge_id] = EdgeInfo{ j - i, bus.bus_number };
+            route_graph.AddEdge({ stops.at(i), stops.at(j), current_time });
+            edges_info_.push_back(EdgeInfo{ j - i, bus.bus_number });
             prev_stop = stops.at(j);
         }
     }
 }
     
 
+// Parts of bus route [first stop index, last stop index] which are ridden without leaving the bus:
+// whole route for round trip, to the last stop and back for straight route
+vector<pair<size_t, size_t>> SingleBusRoute::GetBusTrips(const Bus& bus) {
+    const size_t stops_size = bus.bus_route.size();
+    if (stops_size == 0) {
+        return {};
+    }
+    if (bus.is_roundtrip) {
+        return { {0, stops_size - 1} };
+    }
+    return { {0, stops_size / 2}, {stops_size / 2, stops_size - 1} };
+}
+
+
+// Stops are vertices [0, stops count), compact model adds a vertex for every stop of every bus trip
+size_t SingleBusRoute::CountVertices(const TransportCatalogue& catalogue) {
+    size_t vertex_count = catalogue.GetAllStops().size();
+    if (catalogue.GetRouteGraphModel() == transport::detail::RouteGraphModel::COMPACT) {
+        for (const auto& bus : catalogue.GetAllBuses()) {
+            for (const auto& [first_stop, last_stop] : GetBusTrips(bus)) {
+                vertex_count += last_stop - first_stop + 1;
+            }
+        }
+    }
+    return vertex_count;
+}
+
+
+// Fill graph with one bus trip in COMPACT model: edges count is linear in trip length
+void SingleBusRoute::ProcessCompactBusTrip(const Bus& bus, size_t first_stop, size_t last_stop, VertexId& next_vertex) {
+    const auto bus_velocity = catalogue.BusVelocity();
+    const auto& stops = bus.bus_route;
+
+    for (size_t i = first_stop; i <= last_stop; ++i) {
+        const VertexId stop_vertex = stops.at(i);
+        const VertexId bus_vertex = next_vertex++;
+        if (i < last_stop) {
+            route_graph.AddEdge({ stop_vertex, bus_vertex, static_cast<double>(catalogue.BusWaitTime()) });
+            edges_info_.push_back(EdgeInfo{ 0, bus.bus_number, EdgeType::BOARDING });
+        }
+        if (i > first_stop) {
+            const double ride_time = ((catalogue.StopToStopDst(stops.at(i - 1), stops.at(i)) / 1000.0f) / bus_velocity) * 60;
+            route_graph.AddEdge({ bus_vertex - 1, bus_vertex, ride_time });
+            edges_info_.push_back(EdgeInfo{ 1, bus.bus_number, EdgeType::RIDE });
+            route_graph.AddEdge({ bus_vertex, stop_vertex, 0.0 });
+            edges_info_.push_back(EdgeInfo{ 0, bus.bus_number, EdgeType::ALIGHTING });
+        }
+    }
+}
+
+
+// Edges of bus: every pair of stops of trip in COMPLETE model, boarding, ride and alighting for stop of trip in COMPACT one
+size_t SingleBusRoute::CountBusEdges(const Bus& bus, transport::detail::RouteGraphModel model) {
+    size_t edge_count = 0;
+    for (const auto& [first_stop, last_stop] : GetBusTrips(bus)) {
+        const size_t trip_size = last_stop - first_stop + 1;
+        edge_count += model == transport::detail::RouteGraphModel::COMPACT ? 3 * (trip_size - 1) : trip_size * (trip_size - 1) / 2;
+    }
+    return edge_count;
+}
+
+
+// Only COMPACT model has vertices of buses, one for every stop of trip
+size_t SingleBusRoute::CountBusVertices(const Bus& bus, transport::detail::RouteGraphModel model) {
+    if (model != transport::detail::RouteGraphModel::COMPACT) {
+        return 0;
+    }
+    size_t vertex_count = 0;
+    for (const auto& [first_stop, last_stop] : GetBusTrips(bus)) {
+        vertex_count += last_stop - first_stop + 1;
+    }
+    return vertex_count;
+}
+
+
+// Fill route graph with edges of one bus, vertices of bus in COMPACT model start from next_vertex
+void SingleBusRoute::AddBusEdges(const Bus& bus, VertexId& next_vertex) {
+    if (catalogue.GetRouteGraphModel() == transport::detail::RouteGraphModel::COMPACT) {
+        for (const auto& [first_stop, last_stop] : GetBusTrips(bus)) {
+            ProcessCompactBusTrip(bus, first_stop, last_stop, next_vertex);
+        }
+        return;
+    }
+
+    const auto& stops = bus.bus_route;
+    const auto stops_size = stops.size();
+    if (bus.is_roundtrip) {
+        ProcessRoundBusRoute(bus, stops,  stops_size);
+    } else { 
+        ProcessStraightBusRoute(bus, stops,  stops_size);
+    }
+}
+
+
+// Copy edges [first_edge, last_edge) of bus from old router: stop vertices get new ids of stops,
+// vertices of bus starting from first_vertex go from next_vertex
+void SingleBusRoute::CopyBusEdges(const SingleBusRoute& old_router, size_t first_edge, size_t last_edge, VertexId first_vertex, const Bus& bus,
+                                  const UnchangedBuses& unchanged, VertexId& next_vertex) {
+    const size_t old_stop_count = old_router.catalogue.GetAllStops().size();
+    const auto new_vertex = [&](VertexId vertex) -> VertexId {
+        if (vertex >= old_stop_count) {
+            return vertex - first_vertex + next_vertex;
+        }
+        if (vertex >= unchanged.new_stops.size() || !unchanged.new_stops[vertex]) {
+            throw logic_error("Stop of unchanged bus "s + bus.bus_number + " is removed"s);
+        }
+        return *unchanged.new_stops[vertex];
+    };
+
+    for (size_t edge_id = first_edge; edge_id < last_edge; ++edge_id) {
+        const auto& edge = old_router.route_graph.GetEdge(edge_id);
+        const auto& edge_info = old_router.edges_info_[edge_id];
+        route_graph.AddEdge({ new_vertex(edge.from), new_vertex(edge.to), edge.weight });
+        edges_info_.push_back(EdgeInfo{ edge_info.stop_numb, bus.bus_number, edge_info.type });
+    }
+    next_vertex += CountBusVertices(bus, catalogue.GetRouteGraphModel());
+}
+
+
 // Fill route graph with bus trips info 
 void SingleBusRoute::FillRouteGraph() {
+    VertexId next_vertex = catalogue.GetAllStops().size();
     for (const auto& bus : catalogue.GetAllBuses()) {
-        const auto& stops = bus.bus_route;
-        const auto stops_size = stops.size();
-        if (bus.is_roundtrip) {
-            ProcessRoundBusRoute(bus, stops,  stops_size);
-        } else { 
-            ProcessStraightBusRoute(bus, stops,  stops_size);
+        AddBusEdges(bus, next_vertex);
+    }
+}
+
+
+SingleBusRoute::SingleBusRoute(const TransportCatalogue& cat, const SingleBusRoute& old_router, const UnchangedBuses& unchanged)
+    : catalogue(cat), route_graph(CountVertices(cat)) {
+    const auto& old_catalogue = old_router.catalogue;
+    const auto model = catalogue.GetRouteGraphModel();
+    if (model != old_catalogue.GetRouteGraphModel() || catalogue.BusWaitTime() != old_catalogue.BusWaitTime()
+        || catalogue.BusVelocity() != old_catalogue.BusVelocity()) {
+        FillRouteGraph();
+        CreateRouter();
+        return;
+    }
+
+    // Edges of old bus are [first_edges[bus], first_edges[bus + 1]), its vertices start from first_vertices[bus]
+    const auto& old_buses = old_catalogue.GetAllBuses();
+    vector<size_t> first_edges(old_buses.size() + 1, 0);
+    vector<VertexId> first_vertices(old_buses.size() + 1, old_catalogue.GetAllStops().size());
+    for (size_t bus = 0; bus < old_buses.size(); ++bus) {
+        first_edges[bus + 1] = first_edges[bus] + CountBusEdges(old_buses[bus], model);
+        first_vertices[bus + 1] = first_vertices[bus] + CountBusVertices(old_buses[bus], model);
+    }
+    if (first_edges.back() != old_router.route_graph.GetEdgeCount()) {
+        throw logic_error("Route graph doesn't match the catalogue");
+    }
+
+    // Old id of every vertex of kept stops and unchanged buses
+    vector<optional<VertexId>> old_vertices(route_graph.GetVertexCount());
+    for (StopId stop = 0; stop < unchanged.new_stops.size(); ++stop) {
+        if (unchanged.new_stops[stop]) {
+            old_vertices.at(*unchanged.new_stops[stop]) = stop;
         }
     }
+
+    VertexId next_vertex = catalogue.GetAllStops().size();
+    const auto& buses = catalogue.GetAllBuses();
+    for (size_t bus = 0; bus < buses.size(); ++bus) {
+        const auto old_bus = bus < unchanged.old_buses.size() ? unchanged.old_buses[bus] : nullopt;
+        if (old_bus && *old_bus < old_buses.size()) {
+            for (VertexId vertex = first_vertices[*old_bus]; vertex < first_vertices[*old_bus + 1]; ++vertex) {
+                old_vertices.at(vertex - first_vertices[*old_bus] + next_vertex) = vertex;
+            }
+            CopyBusEdges(old_router, first_edges[*old_bus], first_edges[*old_bus + 1], first_vertices[*old_bus], buses[bus], unchanged, next_vertex);
+        } else {
+            AddBusEdges(buses[bus], next_vertex);
+        }
+    }
+    CreateRouter(old_router, old_vertices);
 }
 
 
- void SingleBusRoute::CreateRouter() {
-     router = new graph::Router<double>(route_graph);
-     if (router == nullptr) {
-         throw logic_error("Router didn't created");
-     }
- }
+SingleBusRoute::SingleBusRoute(const TransportCatalogue& cat, Graph graph, vector<EdgeInfo> edges_info, const RouterFactory& create_router)
+    : catalogue(cat), route_graph(move(graph)), edges_info_(move(edges_info)) {
+    if (route_graph.GetVertexCount() < catalogue.GetAllStops().size() || edges_info_.size() != route_graph.GetEdgeCount()) {
+        throw logic_error("Route graph doesn't match the catalogue");
+    }
+    router = create_router(route_graph);
+}
 
 
-// Create unordered map using for tarnsition StopId to StopName and reverse
-void SingleBusRoute::SaveStopNames() {
-    const auto& stops = catalogue.GetAllStops();
-    for (size_t i = 0; i < stops.size(); ++i) {
-        stops_vertex[stops.at(i).stop_name] = i;
-        vertex_stops[i] = stops.at(i).stop_name;
+// Create routing engine chosen in routing_settings
+void SingleBusRoute::CreateRouter() {
+    switch (catalogue.GetRouterType()) {
+    case transport::detail::RouterType::FLOYD_WARSHALL:
+        router = make_unique<graph::Router<double>>(route_graph);
+        break;
+    case transport::detail::RouterType::DIJKSTRA:
+        router = make_unique<graph::DijkstraRouter<double>>(route_graph);
+        break;
+    case transport::detail::RouterType::CONTRACTION_HIERARCHY:
+        router = make_unique<graph::ContractionHierarchy<double>>(route_graph);
+        break;
+    default:
+        throw logic_error("Unknown router type");
     }
 }
 
+
+// New vertices are contracted first, they are few and are mostly vertices of buses with small degree.
+// Other vertices keep order of old hierarchy, so priorities aren't computed again
+void SingleBusRoute::CreateRouter(const SingleBusRoute& old_router, const vector<optional<VertexId>>& old_vertices) {
+    using ContractionHierarchy = graph::ContractionHierarchy<double>;
+    const auto* old_hierarchy = dynamic_cast<const ContractionHierarchy*>(old_router.router.get());
+    if (catalogue.GetRouterType() != transport::detail::RouterType::CONTRACTION_HIERARCHY || !old_hierarchy) {
+        CreateRouter();
+        return;
+    }
+
+    const auto& old_ranks = old_hierarchy->GetRanks();
+    vector<VertexId> contraction_order;
+    vector<pair<size_t, VertexId>> kept_vertices;
+    contraction_order.reserve(old_vertices.size());
+    kept_vertices.reserve(old_vertices.size());
+    for (VertexId vertex = 0; vertex < old_vertices.size(); ++vertex) {
+        if (old_vertices[vertex]) {
+            kept_vertices.push_back({ old_ranks.at(*old_vertices[vertex]), vertex });
+        } else {
+            contraction_order.push_back(vertex);
+        }
+    }
+    sort(kept_vertices.begin(), kept_vertices.end());
+    for (const auto& [rank, vertex] : kept_vertices) {
+        contraction_order.push_back(vertex);
+    }
+    router = make_unique<ContractionHierarchy>(route_graph, contraction_order);
+}
+
+
 // Create minimal route between stops
 optional<RouteInfo> SingleBusRoute::BuildRoute(string_view from, string_view to) const {
+    if (route_cache_) {
+        return route_cache_->BuildRoute(GetIDStopByName(from), GetIDStopByName(to));
+    }
     return router->BuildRoute(GetIDStopByName(from),  GetIDStopByName(to));
 }
 
 
+void SingleBusRoute::EnableRouteCache(size_t max_bytes) {
+    route_cache_ = make_unique<graph::RouteCache<double>>(route_graph, max_bytes);
+}
+
+
+optional<graph::RouteCacheStats> SingleBusRoute::GetRouteCacheStats() const {
+    if (!route_cache_) {
+        return nullopt;
+    }
+    return route_cache_->GetStats();
+}
+
+
+// Split route into waits and bus rides, works for both graph models
+vector<RouteItem> SingleBusRoute::GetRouteItems(const RouteInfo& route) const {
+    vector<RouteItem> items;
+    items.reserve(route.edges.size() * 2);
+    const double wait_time = catalogue.BusWaitTime();
+
+    for (const auto edge_id : route.edges) {
+        const auto& edge = route_graph.GetEdge(edge_id);
+        const auto& edge_info = edges_info_.at(edge_id);
+        switch (edge_info.type) {
+        case EdgeType::TRIP:
+            items.push_back({ catalogue.GetStop(static_cast<StopId>(edge.from)).stop_name, {}, 0, wait_time });
+            items.push_back({ {}, edge_info.bus_name, edge_info.stop_numb, edge.weight - wait_time });
+            break;
+        case EdgeType::BOARDING:
+            items.push_back({ catalogue.GetStop(static_cast<StopId>(edge.from)).stop_name, {}, 0, edge.weight });
+            items.push_back({ {}, edge_info.bus_name, 0, 0.0 });
+            break;
+        case EdgeType::RIDE:
+            items.back().span_count += edge_info.stop_numb;
+            items.back().time += edge.weight;
+            break;
+        case EdgeType::ALIGHTING:
+            // Getting off right after boarding is a loop, it isn't shown
+            if (items.back().span_count == 0) {
+                items.resize(items.size() - 2);
+            }
+            break;
+        }
+    }
+    return items;
+}
+
+
+// Vertex of stop is its StopId
 size_t SingleBusRoute::GetIDStopByName(string_view stop_name) const {
-    return stops_vertex.at(stop_name);
+    const auto stop = catalogue.FindStopId(stop_name);
+    if (!stop) {
+        throw out_of_range("Unknown stop "s + string(stop_name));
+    }
+    return *stop;
 } 
 
 
 string SingleBusRoute::GetStopNameByEdgeId(size_t edge_id) const {
-    return string(vertex_stops.at(route_graph.GetEdge(edge_id).from));
+    return catalogue.GetStop(static_cast<StopId>(route_graph.GetEdge(edge_id).from)).stop_name;
 }
 
 double SingleBusRoute::GetEdgeWeightByEdgeId(size_t edge_id) const {
@@ -107,9 +366,9 @@ double SingleBusRoute::GetEdgeWeightByEdgeId(size_t edge_id) const {
 }
 
 string SingleBusRoute::GetBusNameByEdgeId(size_t edge_id) const {
-    return string(edge_stop_count_.at(edge_id).bus_name);
+    return string(edges_info_.at(edge_id).bus_name);
 }
 
 int SingleBusRoute::GetStopNumbByEdgeId(size_t edge_id) const {
-    return edge_stop_count_.at(edge_id).stop_numb;
+    return edges_info_.at(edge_id).stop_numb;
 }
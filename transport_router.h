@@ -2,11 +2,17 @@
 
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "route_cache.h"
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include "transport_catalogue.h"
 #include <string_view>
 #include <optional>
+#include <vector>
 
 
 /*
@@ -20,47 +26,114 @@
   
 */
 
+// Kind of route graph edge.
+// COMPLETE graph model has only TRIP edges: wait at stop and ride some stops by one bus.
+// COMPACT graph model has a vertex for every stop of every bus trip: passenger waits on BOARDING edge
+// (stop -> bus), goes to the next stop on RIDE edge (bus -> bus) and gets off on ALIGHTING edge (bus -> stop)
+enum class EdgeType {
+    TRIP,
+    BOARDING,
+    RIDE,
+    ALIGHTING
+};
+
 struct EdgeInfo {
     int stop_numb = 0;
     std::string_view bus_name;
+    EdgeType type = EdgeType::TRIP;
+};
+
+// Part of route for answer: wait at stop (bus_name is empty) or ride span_count stops by bus
+struct RouteItem {
+    std::string_view stop_name;
+    std::string_view bus_name;
+    int span_count = 0;
+    double time = 0;
+};
+
+// Buses of catalogue which are the same as in catalogue of other router, so their edges of route graph are copied
+struct UnchangedBuses {
+    // BusId in old catalogue of every bus, nothing for added or changed bus
+    std::vector<std::optional<transport::detail::BusId>> old_buses;
+    // New StopId of every stop of old catalogue, nothing for removed stop
+    std::vector<std::optional<transport::detail::StopId>> new_stops;
 };
 
 struct SingleBusRoute {
-    using RouteInfo = graph::Router<double>::RouteInfo;
+    using RouteInfo = graph::RoutingEngine<double>::RouteInfo;
     using Bus = transport::detail::Bus;
     using TransportCatalogue = transport::catalogue::TransportCatalogue;
     using VertexId = size_t;
+    using Graph = graph::DirectedWeightedGraph<double>;
+    using RouterFactory = std::function<std::unique_ptr<graph::RoutingEngine<double>>(const Graph&)>;
     
-    SingleBusRoute(const TransportCatalogue& cat) : catalogue(cat), route_graph(catalogue.GetAllStops().size()) {
-        SaveStopNames();
+    // Stops are the first vertices of route graph, vertex of stop is its StopId
+    SingleBusRoute(const TransportCatalogue& cat) : catalogue(cat), route_graph(CountVertices(cat)) {
         FillRouteGraph();
         CreateRouter();
     }
     
-    ~SingleBusRoute() {
-        delete router;
-    }
+    // Use route graph and router precomputed by make_base, create_router gets the stored graph
+    SingleBusRoute(const TransportCatalogue& cat, Graph graph, std::vector<EdgeInfo> edges_info, const RouterFactory& create_router);
+    
+    // Edges of unchanged buses are copied from old router, edges of other buses are computed.
+    // Edges are copied only if routing settings are the same. Routing engine is built anew
+    SingleBusRoute(const TransportCatalogue& cat, const SingleBusRoute& old_router, const UnchangedBuses& unchanged);
+    
+    // Router keeps a reference to route_graph, so the object can't be copied or moved
+    SingleBusRoute(const SingleBusRoute&) = delete;
+    SingleBusRoute& operator=(const SingleBusRoute&) = delete;
     
     std::optional<RouteInfo> BuildRoute(std::string_view from, std::string_view to) const;
+    // Keep shortest path trees of origins taking up to max_bytes, so next routes from them are cheap
+    void EnableRouteCache(size_t max_bytes);
+    // Counters of route cache or nothing if it isn't enabled
+    std::optional<graph::RouteCacheStats> GetRouteCacheStats() const;
+    // Split route into waits and bus rides, works for both graph models
+    std::vector<RouteItem> GetRouteItems(const RouteInfo& route) const;
     std::string GetBusNameByEdgeId(size_t edge_id) const;
     int GetStopNumbByEdgeId(size_t edge_id) const;   
     std::string GetStopNameByEdgeId(size_t edge_id) const;
     double GetEdgeWeightByEdgeId(size_t edge_id) const;
     
+    const Graph& GetGraph() const {
+        return route_graph;
+    }
+    
+    const std::vector<EdgeInfo>& GetEdgesInfo() const {
+        return edges_info_;
+    }
+    
+    const graph::RoutingEngine<double>& GetRouter() const {
+        return *router;
+    }
+    
 private:
     
-    void SaveStopNames();
-    void ProcessStraightBusRoute(const Bus& bus, const std::vector<std::string_view>& stops, size_t stops_size);
-    void ProcessRoundBusRoute(const Bus& bus, const std::vector<std::string_view>& stops, size_t stops_size);
+    // Parts of bus route [first stop index, last stop index] which are ridden without leaving the bus
+    static std::vector<std::pair<size_t, size_t>> GetBusTrips(const Bus& bus);
+    static size_t CountVertices(const TransportCatalogue& catalogue);
+    // Edges and bus vertices which bus adds into route graph of given model
+    static size_t CountBusEdges(const Bus& bus, transport::detail::RouteGraphModel model);
+    static size_t CountBusVertices(const Bus& bus, transport::detail::RouteGraphModel model);
+    
+    void ProcessStraightBusRoute(const Bus& bus, const std::vector<transport::detail::StopId>& stops, size_t stops_size);
+    void ProcessRoundBusRoute(const Bus& bus, const std::vector<transport::detail::StopId>& stops, size_t stops_size);
+    void ProcessCompactBusTrip(const Bus& bus, size_t first_stop, size_t last_stop, VertexId& next_vertex);
+    void AddBusEdges(const Bus& bus, VertexId& next_vertex);
+    void CopyBusEdges(const SingleBusRoute& old_router, size_t first_edge, size_t last_edge, VertexId first_vertex, const Bus& bus,
+                      const UnchangedBuses& unchanged, VertexId& next_vertex);
     void FillRouteGraph();
     void CreateRouter();
+    // Contraction hierarchy contracts vertices in order of old one, old_vertices are old ids of vertices or nothing for new ones
+    void CreateRouter(const SingleBusRoute& old_router, const std::vector<std::optional<VertexId>>& old_vertices);
     size_t GetIDStopByName(std::string_view stop_name) const;
 
     
     const TransportCatalogue& catalogue;
-    graph::DirectedWeightedGraph<double> route_graph;
-    std::unordered_map<std::string_view, size_t> stops_vertex;
-    std::unordered_map<size_t, std::string_view> vertex_stops;
-    std::unordered_map <graph::EdgeId, EdgeInfo> edge_stop_count_;
-    graph::Router<double>* router = nullptr;
+    Graph route_graph;
+    // Bus trip info of every edge, index is EdgeId
+    std::vector<EdgeInfo> edges_info_;
+    std::unique_ptr<graph::RoutingEngine<double>> router;
+    std::unique_ptr<graph::RouteCache<double>> route_cache_;
 };
\ No newline at end of file